@@ -1,7 +1,12 @@
 import pandas as pd
 import matplotlib.pyplot as plt
 
-df = pd.read_csv("bench/results/latency_summary.csv")
+summary = pd.read_csv("bench/results/latency_summary.csv")
+# The older scenario,ops,p50_ns,p90_ns,p99_ns layout has one row per
+# scenario and no per-op or open-loop rows
+if "op" not in summary.columns:
+    summary["op"] = "all"
+df = summary[summary["op"] == "all"]  # one row per scenario; per-op rows are add/cancel/...
 
 sizes = df["ops"]          # uses actual data
 p50 = df["p50_ns"]
@@ -18,4 +23,34 @@ plt.legend()
 plt.grid(True)
 
 plt.savefig("analysis/latency_vs_size.png")
-plt.show()
\ No newline at end of file
+
+# Open-loop sweep (--mode=openloop): tail latency from intended send time vs
+# offered rate, with the service-time tail for contrast
+openloop = summary[summary["op"] == "openloop"]
+service = summary[summary["op"] == "openloop_service"]
+if not openloop.empty and "offered_ops_s" in summary.columns:
+    openloop = openloop.sort_values("offered_ops_s")
+    service = service.sort_values("offered_ops_s")
+    plt.figure()
+    rate = openloop["offered_ops_s"] / 1e6
+    plt.plot(rate, openloop["p50_ns"], marker="o", label="p50")
+    plt.plot(rate, openloop["p99_ns"], marker="o", label="p99")
+    plt.plot(rate, openloop["p999_ns"], marker="o", label="p99.9")
+    plt.plot(service["offered_ops_s"] / 1e6, service["p99_ns"], linestyle="--", marker=".", label="p99 service only")
+
+    # mark rates the engine could not sustain
+    saturated = openloop[openloop["achieved_ops_s"] < 0.97 * openloop["offered_ops_s"]]
+    for _, row in saturated.iterrows():
+        plt.annotate(f"{row['achieved_ops_s'] / 1e6:.2f}M/s", (row["offered_ops_s"] / 1e6, row["p99_ns"]),
+                     textcoords="offset points", xytext=(4, -12), fontsize=8)
+
+    plt.yscale("log")
+    plt.xlabel("Offered Rate (M ops/s)")
+    plt.ylabel("Latency from Intended Send (ns)")
+    plt.title("OME Throughput vs Tail Latency (Open Loop)")
+    plt.legend()
+    plt.grid(True)
+
+    plt.savefig("analysis/latency_vs_rate.png")
+
+plt.show()
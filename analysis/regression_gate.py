@@ -0,0 +1,188 @@
+"""Performance regression gate: baseline vs candidate benchmark results.
+
+Each side is one or more result directories (one per repeated run), each
+holding any of:
+
+  bench_results.csv     per scenario / phase: avg_ns, cycles_per_op, allocs_per_op
+  latency_summary.csv   per scenario / op:    p50_ns, p90_ns, p99_ns
+  microbench.csv        per case / depth:     median_ns (with its own cv_pct)
+
+For every row and metric present on both sides the medians across runs are
+compared. A slowdown is a regression when it exceeds both
+
+  - the relative threshold: max(--threshold, --noise-k * noise), where noise
+    is the run-to-run spread (scaled MAD / median) of the baseline and
+    candidate runs, or the row's own cv_pct for microbench results, and
+  - the absolute floor (--abs-floor-ns, in the metric's unit), which keeps
+    histogram bucket steps on ~10 ns values from tripping the gate.
+
+allocs_per_op is exact: any increase above --alloc-epsilon is a regression.
+
+Usage:
+  python analysis/regression_gate.py --baseline runs/base_* --candidate runs/cand_*
+  python analysis/regression_gate.py --baseline base --candidate bench/results --csv gate.csv
+
+Exit status: 0 no regression, 1 regression, 2 nothing comparable / bad input.
+"""
+
+import argparse
+import csv
+import math
+import os
+import statistics
+import sys
+
+# file -> (key columns, compared metrics)
+TABLES = {
+    "bench_results.csv": (("scenario", "phase"), ("avg_ns", "cycles_per_op", "allocs_per_op")),
+    "latency_summary.csv": (("scenario", "op"), ("p50_ns", "p90_ns", "p99_ns")),
+    "microbench.csv": (("case", "depth"), ("median_ns",)),
+}
+
+# Rows that describe the measurement clock rather than the engine
+SKIP_OPS = {"probe_overhead"}
+
+MAD_SCALE = 1.4826  # MAD -> stddev for normal data
+
+
+class InputError(Exception):
+    """A result file that cannot be read; exits 2, never as a regression."""
+
+
+def load_runs(dirs):
+    """{(file, key, metric): [value per run]} and {(file, key): [cv_pct per run]}.
+
+    Tables without the key columns (e.g. a latency_summary.csv written in the
+    older scenario,ops,p50_ns,... layout) are skipped with a warning.
+    """
+    values, cvs = {}, {}
+    for d in dirs:
+        for name, (key_cols, metrics) in TABLES.items():
+            path = os.path.join(d, name)
+            if not os.path.exists(path):
+                continue
+            try:
+                with open(path, newline="") as f:
+                    reader = csv.DictReader(f)
+                    missing = [c for c in key_cols if c not in (reader.fieldnames or ())]
+                    if missing:
+                        print(f"regression_gate: skipping {path}: no {', '.join(missing)} column", file=sys.stderr)
+                        continue
+                    for line, row in enumerate(reader, start=2):
+                        key = tuple(row[c] or "" for c in key_cols)
+                        if key[-1] in SKIP_OPS:
+                            continue
+                        try:
+                            for m in metrics:
+                                v = row.get(m, "")
+                                if v not in ("", None):
+                                    values.setdefault((name, key, m), []).append(float(v))
+                            if row.get("cv_pct"):
+                                cvs.setdefault((name, key), []).append(float(row["cv_pct"]) / 100.0)
+                        except ValueError as e:
+                            raise InputError(f"{path}:{line}: {e}") from e
+            except (OSError, csv.Error, UnicodeDecodeError) as e:
+                raise InputError(f"{path}: {e}") from e
+    return values, cvs
+
+
+def rel_spread(samples):
+    """Scaled median absolute deviation relative to the median (0 for one run)."""
+    if len(samples) < 2:
+        return 0.0
+    med = statistics.median(samples)
+    if med == 0:
+        return 0.0
+    mad = statistics.median(abs(s - med) for s in samples)
+    return MAD_SCALE * mad / abs(med)
+
+
+def compare(base, cand, base_cv, cand_cv, args):
+    rows = []
+    for ident in sorted(base.keys() & cand.keys()):
+        name, key, metric = ident
+        b, c = base[ident], cand[ident]
+        b_med, c_med = statistics.median(b), statistics.median(c)
+        delta = c_med - b_med
+        rel = delta / b_med if b_med else (math.inf if delta > 0 else 0.0)
+
+        if metric == "allocs_per_op":
+            limit = None
+            regressed = delta > args.alloc_epsilon
+        else:
+            noise = max(rel_spread(b), rel_spread(c))
+            for cv in (base_cv.get((name, key)), cand_cv.get((name, key))):
+                if cv:
+                    noise = max(noise, statistics.median(cv))
+            limit = max(args.threshold, args.noise_k * noise)
+            regressed = rel > limit and delta > args.abs_floor_ns
+        improved = (not regressed) and limit is not None and -rel > limit and -delta > args.abs_floor_ns
+
+        rows.append({
+            "file": name,
+            "key": "/".join(key),
+            "metric": metric,
+            "baseline": b_med,
+            "candidate": c_med,
+            "delta": delta,
+            "delta_pct": 100.0 * rel if math.isfinite(rel) else rel,
+            "limit_pct": 100.0 * limit if limit is not None else 0.0,
+            "runs": f"{len(b)}/{len(c)}",
+            "status": "REGRESSION" if regressed else ("improved" if improved else "ok"),
+        })
+    return rows
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--baseline", nargs="+", required=True, help="baseline result dir(s), one per run")
+    ap.add_argument("--candidate", nargs="+", required=True, help="candidate result dir(s), one per run")
+    ap.add_argument("--threshold", type=float, default=0.05, help="minimum relative slowdown to flag (default 0.05)")
+    ap.add_argument("--noise-k", type=float, default=3.0, help="noise multiplier for the relative limit (default 3)")
+    ap.add_argument("--abs-floor-ns", type=float, default=5.0, help="ignore slowdowns smaller than this (default 5)")
+    ap.add_argument("--alloc-epsilon", type=float, default=0.0001, help="tolerated allocs_per_op increase")
+    ap.add_argument("--metrics", nargs="+", help="compare only these metrics (e.g. avg_ns p99_ns)")
+    ap.add_argument("--csv", help="also write every comparison to this CSV")
+    ap.add_argument("--all", action="store_true", help="print ok rows too")
+    args = ap.parse_args()
+
+    try:
+        base, base_cv = load_runs(args.baseline)
+        cand, cand_cv = load_runs(args.candidate)
+    except InputError as e:
+        print(f"regression_gate: {e}", file=sys.stderr)
+        return 2
+    if args.metrics:
+        base = {k: v for k, v in base.items() if k[2] in args.metrics}
+        cand = {k: v for k, v in cand.items() if k[2] in args.metrics}
+
+    rows = compare(base, cand, base_cv, cand_cv, args)
+    if not rows:
+        print("regression_gate: no rows in common between baseline and candidate", file=sys.stderr)
+        return 2
+
+    missing = sorted(base.keys() - cand.keys())
+    for name, key, metric in missing:
+        print(f"[MISSING] {name} {'/'.join(key)} {metric}: not in candidate")
+
+    shown = rows if args.all else [r for r in rows if r["status"] != "ok"]
+    if shown:
+        print(f"{'status':<11} {'file':<20} {'key':<36} {'metric':<14} {'baseline':>12} {'candidate':>12} {'delta%':>8} {'limit%':>7} runs")
+    for r in shown:
+        print(f"{r['status']:<11} {r['file']:<20} {r['key']:<36} {r['metric']:<14} "
+              f"{r['baseline']:>12.2f} {r['candidate']:>12.2f} {r['delta_pct']:>+8.1f} {r['limit_pct']:>7.1f} {r['runs']}")
+
+    if args.csv:
+        with open(args.csv, "w", newline="") as f:
+            w = csv.DictWriter(f, fieldnames=list(rows[0].keys()))
+            w.writeheader()
+            w.writerows(rows)
+
+    regressions = sum(r["status"] == "REGRESSION" for r in rows)
+    improved = sum(r["status"] == "improved" for r in rows)
+    print(f"[GATE] {len(rows)} compared, {regressions} regressed, {improved} improved, {len(missing)} missing")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
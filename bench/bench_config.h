@@ -1,9 +1,27 @@
 #pragma once
+#include "workload_generator.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <vector>
 
 enum class RunMode {
     Correctness,
-    Performance
+    Performance,
+    Pipeline,       // two-thread front end: gateway -> SPSC ring -> matching thread
+    Shards,         // multi-symbol engine scaling from 1 to N shards
+    Restart,        // snapshot a large book, restore it and replay a trace tail
+    Wal,            // write-ahead command log: group-commit size sweep + recovery
+    Batch,          // ProcessBatch throughput vs batch size
+    OpenLoop        // fixed-rate schedule, latency from intended send time
+};
+
+// Book layout(s) exercised by each scenario
+enum class BookChoice {
+    Map,
+    Ladder,
+    Both        // run every scenario on each layout (head-to-head)
 };
 
 struct BenchPaths {
@@ -27,5 +45,16 @@ struct BenchPaths {
 struct BenchConfig {
     RunMode mode = RunMode::Correctness;
     bool enable_events = false;
+    BookChoice book = BookChoice::Map;
+    int matching_cpu = -1;      // pipeline mode: core for the matching thread (-1 = auto)
+    size_t shards = 0;          // shards mode: largest shard count (0 = hardware threads - 1)
+    size_t symbols = 256;       // shards mode: number of symbols
+    uint64_t restart_orders = 1'000'000;    // restart mode: resting orders before the snapshot
+    uint64_t wal_ops = 100'000;             // wal mode: commands per group-commit run
+    uint64_t depth_orders = 1'000'000;      // batch / openloop modes: resting orders before the timed flow
+    std::vector<uint64_t> openloop_rates{ 250'000, 500'000, 1'000'000, 2'000'000, 4'000'000, 8'000'000 };  // offered ops/s
+    uint64_t openloop_ms = 500;             // openloop mode: scheduled duration per rate
+    bool steady_clock = false;  // latency probes on steady_clock even if the TSC is usable
+    std::optional<WorkloadConfig> workload;     // --workload=<file>: modelled order flow instead of uniform
     BenchPaths paths;
 };
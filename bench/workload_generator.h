@@ -0,0 +1,342 @@
+#pragma once
+
+#include "OrderType.h"
+#include "Side.h"
+#include "Usings.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Pre-generated op used to drive several books (or the matching thread)
+// with identical flow. arrival_ns is the op's send time on the workload
+// generator's clock (0 for the uniform default flow).
+struct BenchOp {
+    enum Kind : uint8_t { Add, Cancel, Modify } kind;
+    OrderType type;
+    Side side;
+    uint32_t id;
+    Price price;
+    Quantity qty;
+    uint64_t arrival_ns = 0;
+};
+
+// ---------- workload configuration ----------
+// Parameters of the order-flow model, loaded from a `key = value` file
+// (`#` starts a comment). Every key is optional; see
+// bench/workloads/liquid.cfg for a documented example.
+enum class OffsetDist : uint8_t {
+    Geometric,      // P(k) = p (1 - p)^k
+    PowerLaw,       // P(offset >= k) ~ (k + 1)^-alpha
+    Uniform         // 0..max_offset
+};
+
+struct WorkloadConfig {
+    uint64_t seed = 1;
+
+    // Mid price: starts at start_mid (0 = middle of the book's band) and on
+    // each arrival moves one mid_tick up or down with probability mid_move_prob
+    Price start_mid = 0;
+    Price mid_tick = 1;
+    double mid_move_prob = 0.02;
+    Price half_spread = 1;          // touch = mid -/+ half_spread
+
+    // Passive prices sit offset ticks behind the touch
+    OffsetDist offset_dist = OffsetDist::Geometric;
+    double offset_p = 0.25;         // geometric
+    double offset_alpha = 1.5;      // power law
+    Price max_offset = 200;
+    double marketable_frac = 0.05;  // limit adds priced up to max_cross ticks through the touch
+    Price max_cross = 3;
+
+    // Sizes: qty_min + geometric(qty_p) extra lots, capped at qty_max
+    Quantity qty_min = 1;
+    Quantity qty_max = 100;
+    double qty_p = 0.3;
+
+    // Arrival mix (the rest are GTC adds)
+    double modify_frac = 0.05;
+    double modify_resize_share = 0.5;   // modifies that shrink in place
+    double ioc_frac = 0.03;
+    double fok_frac = 0.01;
+    double market_frac = 0.01;
+
+    // GTC lifetimes: exponential, a fleeting share with a much shorter mean.
+    // A cancel is sent when an order's lifetime ends (even if it has filled)
+    double lifetime_mean_us = 2000.0;
+    double fleeting_frac = 0.5;
+    double fleeting_mean_us = 50.0;
+
+    // Arrivals: exponential gaps; bursts (entered with burst_prob per
+    // arrival, ~burst_len arrivals long) shrink gaps by burst_speedup and
+    // lifetimes by burst_lifetime_scale
+    double arrival_gap_ns = 1000.0;
+    double burst_prob = 0.002;
+    double burst_len = 200.0;
+    double burst_speedup = 20.0;
+    double burst_lifetime_scale = 0.1;
+};
+
+inline WorkloadConfig LoadWorkloadConfig(const std::string &path)
+{
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Workload config (" + path + "): cannot open");
+
+    WorkloadConfig c;
+    auto fail = [&](size_t line, const std::string &what) {
+        std::ostringstream oss;
+        oss << "Workload config (" << path << ":" << line << "): " << what;
+        throw std::runtime_error(oss.str());
+    };
+
+    std::string text;
+    for (size_t line = 1; std::getline(in, text); ++line) {
+        text = text.substr(0, text.find('#'));
+        size_t eq = text.find('=');
+        auto trim = [](std::string s) {
+            s.erase(0, s.find_first_not_of(" \t\r"));
+            s.erase(s.find_last_not_of(" \t\r") + 1);
+            return s;
+        };
+        std::string key = trim(text.substr(0, eq));
+        if (key.empty()) continue;
+        if (eq == std::string::npos) fail(line, "expected key = value");
+        std::string value = trim(text.substr(eq + 1));
+
+        try {
+            if (key == "seed") c.seed = std::stoull(value);
+            else if (key == "start_mid") c.start_mid = std::stoi(value);
+            else if (key == "mid_tick") c.mid_tick = std::stoi(value);
+            else if (key == "mid_move_prob") c.mid_move_prob = std::stod(value);
+            else if (key == "half_spread") c.half_spread = std::stoi(value);
+            else if (key == "offset_dist") {
+                if (value == "geometric") c.offset_dist = OffsetDist::Geometric;
+                else if (value == "power_law") c.offset_dist = OffsetDist::PowerLaw;
+                else if (value == "uniform") c.offset_dist = OffsetDist::Uniform;
+                else fail(line, "offset_dist must be geometric, power_law or uniform");
+            }
+            else if (key == "offset_p") c.offset_p = std::stod(value);
+            else if (key == "offset_alpha") c.offset_alpha = std::stod(value);
+            else if (key == "max_offset") c.max_offset = std::stoi(value);
+            else if (key == "marketable_frac") c.marketable_frac = std::stod(value);
+            else if (key == "max_cross") c.max_cross = std::stoi(value);
+            else if (key == "qty_min") c.qty_min = static_cast<Quantity>(std::stoul(value));
+            else if (key == "qty_max") c.qty_max = static_cast<Quantity>(std::stoul(value));
+            else if (key == "qty_p") c.qty_p = std::stod(value);
+            else if (key == "modify_frac") c.modify_frac = std::stod(value);
+            else if (key == "modify_resize_share") c.modify_resize_share = std::stod(value);
+            else if (key == "ioc_frac") c.ioc_frac = std::stod(value);
+            else if (key == "fok_frac") c.fok_frac = std::stod(value);
+            else if (key == "market_frac") c.market_frac = std::stod(value);
+            else if (key == "lifetime_mean_us") c.lifetime_mean_us = std::stod(value);
+            else if (key == "fleeting_frac") c.fleeting_frac = std::stod(value);
+            else if (key == "fleeting_mean_us") c.fleeting_mean_us = std::stod(value);
+            else if (key == "arrival_gap_ns") c.arrival_gap_ns = std::stod(value);
+            else if (key == "burst_prob") c.burst_prob = std::stod(value);
+            else if (key == "burst_len") c.burst_len = std::stod(value);
+            else if (key == "burst_speedup") c.burst_speedup = std::stod(value);
+            else if (key == "burst_lifetime_scale") c.burst_lifetime_scale = std::stod(value);
+            else fail(line, "unknown key '" + key + "'");
+        } catch (const std::logic_error &) {
+            fail(line, "bad value for '" + key + "'");
+        }
+    }
+
+    if (c.offset_p <= 0 || c.offset_p > 1 || c.qty_p <= 0 || c.qty_p > 1)
+        throw std::runtime_error("Workload config (" + path + "): offset_p and qty_p must be in (0, 1]");
+    if (c.qty_min == 0 || c.qty_max < c.qty_min || c.mid_tick <= 0 || c.half_spread < 0 || c.max_offset < 0)
+        throw std::runtime_error("Workload config (" + path + "): bad price / size bounds");
+    if (c.arrival_gap_ns <= 0 || c.lifetime_mean_us <= 0 || c.fleeting_mean_us <= 0 || c.burst_len < 1 || c.burst_speedup <= 0)
+        throw std::runtime_error("Workload config (" + path + "): gaps, lifetimes and burst sizes must be positive");
+    return c;
+}
+
+// ---------- workload generator ----------
+// Discrete-event order-flow model over a simulated clock. Each arrival
+// (exponential gaps, faster inside bursts) steps the mid-price random walk,
+// then is a modify of a live GTC order or an add; GTC adds draw a lifetime
+// and a cancel is emitted when it expires. Passive prices sit a drawn
+// offset behind the touch; a marketable share crosses it. Cancels and
+// modifies only target orders this generator added, and it does not see
+// fills, so some cancels / modifies hit orders that already traded (the
+// book treats them as no-ops, like a late cancel on an exchange).
+//
+// Ids are assigned sequentially from first_id. The same config, band,
+// first id and stream give the same ops on every run.
+class WorkloadGenerator {
+    static constexpr uint32_t NotLive = std::numeric_limits<uint32_t>::max();
+
+    struct LiveOrder { uint32_t id; Side side; Price price; Quantity qty; };
+
+    WorkloadConfig cfg_;
+    std::mt19937_64 rng_;
+    std::uniform_real_distribution<double> unit_{ 0.0, 1.0 };
+    Price min_price_, max_price_;
+    Price mid_;
+    uint32_t first_id_, next_id_;
+
+    uint64_t now_ns_ = 0;
+    uint64_t next_arrival_ns_ = 0;
+    uint64_t burst_left_ = 0;
+    bool last_resize_ = false;
+
+    std::vector<LiveOrder> live_;
+    std::vector<uint32_t> slot_;    // id - first_id -> index in live_ (NotLive once gone)
+    using Expiry = std::pair<uint64_t, uint32_t>;
+    std::priority_queue<Expiry, std::vector<Expiry>, std::greater<Expiry>> expiries_;
+
+    double exponential(double mean) { return -mean * std::log(1.0 - unit_(rng_)); }
+
+    uint64_t geometric(double p) {
+        if (p >= 1.0) return 0;
+        return static_cast<uint64_t>(std::log(1.0 - unit_(rng_)) / std::log(1.0 - p));
+    }
+
+    Price offset() {
+        uint64_t k = 0;
+        switch (cfg_.offset_dist) {
+        case OffsetDist::Geometric: k = geometric(cfg_.offset_p); break;
+        case OffsetDist::PowerLaw:
+            k = static_cast<uint64_t>(std::min(std::pow(1.0 - unit_(rng_), -1.0 / cfg_.offset_alpha),
+                                               static_cast<double>(cfg_.max_offset) + 1.0)) - 1;
+            break;
+        case OffsetDist::Uniform:   k = static_cast<uint64_t>(unit_(rng_) * (cfg_.max_offset + 1)); break;
+        }
+        return static_cast<Price>(std::min<uint64_t>(k, static_cast<uint64_t>(cfg_.max_offset)));
+    }
+
+    Quantity quantity() {
+        uint64_t q = cfg_.qty_min + geometric(cfg_.qty_p);
+        return static_cast<Quantity>(std::min<uint64_t>(q, cfg_.qty_max));
+    }
+
+    Price clamp(Price p) const { return std::clamp(p, min_price_, max_price_); }
+
+    // Passive: offset behind the touch; marketable: up to max_cross through it
+    Price limit_price(Side side, bool marketable) {
+        Price touch = side == Side::Buy ? mid_ - cfg_.half_spread : mid_ + cfg_.half_spread;
+        Price opposite = side == Side::Buy ? mid_ + cfg_.half_spread : mid_ - cfg_.half_spread;
+        if (marketable) {
+            Price cross = static_cast<Price>(unit_(rng_) * (cfg_.max_cross + 1));
+            return clamp(side == Side::Buy ? opposite + cross : opposite - cross);
+        }
+        Price off = offset();
+        return clamp(side == Side::Buy ? touch - off : touch + off);
+    }
+
+    void step_mid() {
+        if (unit_(rng_) >= cfg_.mid_move_prob) return;
+        Price lo = min_price_ + cfg_.half_spread, hi = max_price_ - cfg_.half_spread;
+        Price step = unit_(rng_) < 0.5 ? -cfg_.mid_tick : cfg_.mid_tick;
+        if (mid_ + step < lo || mid_ + step > hi) step = -step;     // reflect at the band edges
+        mid_ = std::clamp(mid_ + step, lo, hi);
+    }
+
+    void remove_live(uint32_t id) {
+        uint32_t &slot = slot_[id - first_id_];
+        live_[slot] = live_.back();
+        slot_[live_[slot].id - first_id_] = slot;
+        live_.pop_back();
+        slot = NotLive;
+    }
+
+    BenchOp arrival() {
+        now_ns_ = next_arrival_ns_;
+        if (burst_left_ == 0 && unit_(rng_) < cfg_.burst_prob)
+            burst_left_ = 1 + geometric(1.0 / cfg_.burst_len);
+        const bool burst = burst_left_ > 0;
+        if (burst) --burst_left_;
+        double gap = burst ? cfg_.arrival_gap_ns / cfg_.burst_speedup : cfg_.arrival_gap_ns;
+        next_arrival_ns_ = now_ns_ + 1 + static_cast<uint64_t>(exponential(gap));
+        step_mid();
+
+        const Side side = unit_(rng_) < 0.5 ? Side::Buy : Side::Sell;
+        double r = unit_(rng_);
+        if (r < cfg_.modify_frac && !live_.empty()) {
+            LiveOrder &o = live_[static_cast<size_t>(unit_(rng_) * live_.size())];
+            last_resize_ = unit_(rng_) < cfg_.modify_resize_share;
+            if (last_resize_) {
+                o.qty = std::max<Quantity>(1, o.qty / 2);
+            } else {
+                o.price = limit_price(o.side, unit_(rng_) < cfg_.marketable_frac);
+                o.qty = quantity();
+            }
+            return {BenchOp::Modify, OrderType::GoodTillCancel, o.side, o.id, o.price, o.qty, now_ns_};
+        }
+
+        const uint32_t id = next_id_++;
+        slot_.push_back(NotLive);
+        r = unit_(rng_);
+        if (r < cfg_.market_frac)
+            return {BenchOp::Add, OrderType::Market, side, id, 0, quantity(), now_ns_};
+        r -= cfg_.market_frac;
+        if (r < cfg_.ioc_frac + cfg_.fok_frac) {
+            OrderType type = r < cfg_.ioc_frac ? OrderType::ImmediateOrCancel : OrderType::FillOrKill;
+            return {BenchOp::Add, type, side, id, limit_price(side, true), quantity(), now_ns_};
+        }
+
+        BenchOp op{BenchOp::Add, OrderType::GoodTillCancel, side, id,
+                   limit_price(side, unit_(rng_) < cfg_.marketable_frac), quantity(), now_ns_};
+        double mean_us = unit_(rng_) < cfg_.fleeting_frac ? cfg_.fleeting_mean_us : cfg_.lifetime_mean_us;
+        if (burst) mean_us *= cfg_.burst_lifetime_scale;
+        slot_.back() = static_cast<uint32_t>(live_.size());
+        live_.push_back({id, side, op.price, op.qty});
+        expiries_.push({now_ns_ + 1 + static_cast<uint64_t>(exponential(mean_us * 1000.0)), id});
+        return op;
+    }
+
+public:
+    WorkloadGenerator(const WorkloadConfig &cfg, Price minPrice, Price maxPrice,
+                      uint32_t firstId = 6'000'000, uint64_t stream = 0)
+        : cfg_{ cfg }
+        , rng_{ cfg.seed ^ (stream * 0x9E3779B97F4A7C15ULL) }
+        , min_price_{ minPrice }
+        , max_price_{ maxPrice }
+        , first_id_{ firstId }
+        , next_id_{ firstId }
+    {
+        Price lo = min_price_ + cfg_.half_spread, hi = max_price_ - cfg_.half_spread;
+        mid_ = cfg_.start_mid > 0 ? cfg_.start_mid : min_price_ + (max_price_ - min_price_) / 2;
+        mid_ = std::clamp(mid_, lo, std::max(lo, hi));
+        next_arrival_ns_ = static_cast<uint64_t>(exponential(cfg_.arrival_gap_ns));
+    }
+
+    // Next op in send-time order: an expired order's cancel if it is due
+    // before the next arrival, otherwise the arrival
+    BenchOp Next() {
+        while (!expiries_.empty() && expiries_.top().first <= next_arrival_ns_) {
+            auto [when, id] = expiries_.top();
+            expiries_.pop();
+            if (slot_[id - first_id_] == NotLive) continue;
+            now_ns_ = when;
+            const LiveOrder &o = live_[slot_[id - first_id_]];
+            BenchOp op{BenchOp::Cancel, OrderType::GoodTillCancel, o.side, id, 0, 0, now_ns_};
+            remove_live(id);
+            return op;
+        }
+        return arrival();
+    }
+
+    // Resting depth for pre-loading a book (warmup / bulk): a passive GTC
+    // order behind the touch with the caller's id. Not tracked, so it is
+    // never cancelled or modified by Next().
+    BenchOp Resting(uint32_t id, Side side) {
+        return {BenchOp::Add, OrderType::GoodTillCancel, side, id, limit_price(side, false), quantity(), now_ns_};
+    }
+
+    // Whether the last modify from Next() kept side and price (shrink in place)
+    bool LastModifyResize() const { return last_resize_; }
+    Price Mid() const { return mid_; }
+    uint64_t NowNs() const { return now_ns_; }
+    size_t LiveOrders() const { return live_.size(); }
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "Usings.h"
+#include "Order.h"
+#include "OrderModify.h"
+#include "Trade.h"
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <vector>
+
+// Binary op trace: a 64-byte header followed by fixed 16-byte records, one
+// per ADD / CANCEL / MATCH / MODIFY. It carries exactly what the CSV trace
+// (trace_ops_<scenario>.csv) carries, so the two convert losslessly.
+// Integers are stored in host byte order. Order ids are stored in 32 bits;
+// the CSV converter rejects ids, types, sides, prices and quantities the
+// record cannot hold rather than truncating them.
+
+enum class TraceOp : std::uint8_t{
+    Add = 1,
+    Cancel = 2,
+    Match = 3,
+    Modify = 4
+};
+
+struct TraceRecord{
+    TraceOp op_;
+    std::uint8_t orderType_;    // OrderType, ADD only
+    std::uint8_t side_;         // Side, ADD / MODIFY
+    std::uint8_t reserved_;
+    std::uint32_t orderId_;
+    Price price_;
+    Quantity quantity_;
+};
+static_assert(sizeof(TraceRecord) == 16, "trace records are fixed-width");
+
+struct TraceHeader{
+    char magic_[8];             // "OMETRACE"
+    std::uint16_t version_;
+    std::uint16_t recordSize_;
+    std::uint32_t reserved_;
+    std::uint64_t seed_;
+    std::uint64_t recordCount_;
+    char scenario_[32];         // NUL-padded
+};
+static_assert(sizeof(TraceHeader) == 64, "trace header is fixed-width");
+
+constexpr std::uint16_t TraceVersion = 1;
+
+// Buffers records and writes them in bulk; the header's record count is
+// patched on Close. Throws std::runtime_error on I/O failure.
+class BinaryTraceWriter{
+private:
+    std::FILE* file_{ nullptr };
+    std::vector<TraceRecord> buffer_;
+    std::uint64_t count_{ 0 };
+
+    void Append(const TraceRecord& record){
+        buffer_.push_back(record);
+        if(buffer_.size() == buffer_.capacity())
+            Flush();
+    }
+    void Flush();
+
+public:
+    BinaryTraceWriter() = default;
+    BinaryTraceWriter(const BinaryTraceWriter&) = delete;
+    BinaryTraceWriter& operator=(const BinaryTraceWriter&) = delete;
+    ~BinaryTraceWriter();
+
+    void Open(const std::string& path, std::uint64_t seed, const std::string& scenario);
+    void Close();
+    bool IsOpen() const { return file_ != nullptr; }
+
+    void WriteAdd(std::uint32_t id, OrderType type, Side side, Price price, Quantity quantity){
+        Append({ TraceOp::Add, static_cast<std::uint8_t>(type), static_cast<std::uint8_t>(side), 0, id, price, quantity });
+    }
+    void WriteCancel(std::uint32_t id){
+        Append({ TraceOp::Cancel, 0, 0, 0, id, 0, 0 });
+    }
+    void WriteMatch(){
+        Append({ TraceOp::Match, 0, 0, 0, 0, 0, 0 });
+    }
+    void WriteModify(std::uint32_t id, Side side, Price price, Quantity quantity){
+        Append({ TraceOp::Modify, 0, static_cast<std::uint8_t>(side), 0, id, price, quantity });
+    }
+};
+
+// Read-only memory mapping of a binary trace. Records are used in place;
+// nothing is copied or allocated per record. Throws std::runtime_error if
+// the file cannot be mapped or its header is invalid.
+class MappedTrace{
+private:
+    const unsigned char* data_{ nullptr };
+    std::size_t size_{ 0 };
+#if defined(_WIN32)
+    void* file_{ nullptr };
+    void* mapping_{ nullptr };
+#else
+    int fd_{ -1 };
+#endif
+
+    void Unmap();
+
+public:
+    explicit MappedTrace(const std::string& path);
+    MappedTrace(const MappedTrace&) = delete;
+    MappedTrace& operator=(const MappedTrace&) = delete;
+    ~MappedTrace();
+
+    const TraceHeader& Header() const { return *reinterpret_cast<const TraceHeader*>(data_); }
+    std::span<const TraceRecord> Records() const {
+        return { reinterpret_cast<const TraceRecord*>(data_ + sizeof(TraceHeader)), Header().recordCount_ };
+    }
+};
+
+// Applies records to any book exposing the sink API; returns ops applied
+template <typename Book>
+std::size_t ReplayTraceRecords(Book& book, std::span<const TraceRecord> records, Trades& fills)
+{
+    for(const TraceRecord& r : records){
+        fills.clear();
+        switch(r.op_){
+        case TraceOp::Add:
+            book.AddOrder(Order{ static_cast<OrderType>(r.orderType_), r.orderId_, static_cast<Side>(r.side_), r.price_, r.quantity_ }, fills);
+            break;
+        case TraceOp::Cancel:
+            book.CancelOrder(r.orderId_);
+            break;
+        case TraceOp::Match:
+            book.MatchOrders(fills);
+            break;
+        case TraceOp::Modify:
+            book.MatchOrder(OrderModify{ r.orderId_, static_cast<Side>(r.side_), r.price_, r.quantity_ }, fills);
+            break;
+        }
+    }
+    return records.size();
+}
+
+// CSV <-> binary conversion (CSV format as written by the benchmark harness).
+// Both return the number of records converted.
+std::uint64_t ConvertTraceCsvToBinary(const std::string& csvPath, const std::string& binPath);
+std::uint64_t ConvertTraceBinaryToCsv(const std::string& binPath, const std::string& csvPath);
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Usings.h"
+#include "Side.h"
+#include "PriceLevel.h"
+#include "OrderbookConfig.h"
+#include "PriceLadder.h"
+#include <functional>
+#include <limits>
+#include <map>
+#include <type_traits>
+
+// Price levels for one side of the book. The storage (std::map or flat
+// PriceLadder) is chosen once at construction; all accessors present levels
+// in priority order (descending for bids, ascending for asks).
+template <Side S>
+class BookSide{
+private:
+    using Compare = std::conditional_t<S == Side::Buy, std::greater<Price>, std::less<Price>>;
+
+    bool useLadder_{ false };
+    std::map<Price, PriceLevel, Compare> map_;
+    PriceLadder<S> ladder_;
+
+public:
+    explicit BookSide(const OrderbookConfig& config)
+        : useLadder_{ config.layout_ == BookLayout::Ladder }
+    {
+        if(useLadder_)
+            ladder_ = PriceLadder<S>(config.minPrice_, config.maxPrice_);
+    }
+
+    bool Empty() const { return useLadder_ ? ladder_.Empty() : map_.empty(); }
+    std::size_t LevelCount() const { return useLadder_ ? ladder_.LevelCount() : map_.size(); }
+
+    // Lowest / highest price a level can be created at
+    Price PriceFloor() const { return useLadder_ ? ladder_.GetMinPrice() : 1; }
+    Price PriceCeiling() const { return useLadder_ ? ladder_.GetMaxPrice() : std::numeric_limits<Price>::max(); }
+    // Whether AddLevel(price) can succeed (a map book takes any price)
+    bool InBand(Price price) const { return !useLadder_ || ladder_.InBand(price); }
+
+    Price BestPrice() const { return useLadder_ ? ladder_.BestPrice() : map_.begin()->first; }
+    PriceLevel& BestLevel() { return useLadder_ ? ladder_.BestLevel() : map_.begin()->second; }
+    const PriceLevel& BestLevel() const { return useLadder_ ? ladder_.BestLevel() : map_.begin()->second; }
+
+    PriceLevel& Level(Price price) { return useLadder_ ? ladder_.Level(price) : map_[price]; }
+    PriceLevel& AddLevel(Price price) { return useLadder_ ? ladder_.AddLevel(price) : map_[price]; }
+
+    void EraseLevel(Price price){
+        if(useLadder_)
+            ladder_.EraseLevel(price);
+        else
+            map_.erase(price);
+    }
+
+    // Visits levels best-first; fn(price, orders) returns false to stop
+    template <typename Fn>
+    void ForEachLevel(Fn&& fn) const {
+        if(useLadder_){
+            ladder_.ForEachLevel(fn);
+            return;
+        }
+        for(const auto& [price, orders] : map_){
+            if(!fn(price, orders))
+                return;
+        }
+    }
+};
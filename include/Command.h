@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Usings.h"
+#include "Event.h"
+#include "OrderType.h"
+#include "Side.h"
+#include "TradeInfo.h"
+#include <cstdint>
+
+enum class CommandType : std::uint8_t{
+    Add,
+    Cancel,
+    Modify
+};
+
+// Fixed-size request handed to the matching thread. Cancel only reads
+// orderId_; Add and Modify read every field except that Modify ignores
+// orderType_ (the resting order's type is kept). symbol_ selects the book.
+// tag_ is opaque to the engine and echoed on every report the command
+// produces.
+struct Command{
+    CommandType type_{ CommandType::Add };
+    SymbolId symbol_{ 0 };
+    OrderType orderType_{ OrderType::GoodTillCancel };
+    Side side_{ Side::Buy };
+    OrderId orderId_{ 0 };
+    Price price_{ 0 };
+    Quantity quantity_{ 0 };
+    std::uint64_t tag_{ 0 };
+};
+
+enum class ReportType : std::uint8_t{
+    Fill,   // one trade; bid_/ask_ hold both legs
+    Done,   // command fully processed; fillCount_ fills preceded it
+    Reject, // command refused (no book for its symbol, or the book threw); its Done follows
+    Event   // one book event (events_ enabled); event_ holds it
+};
+
+// Outbound record published by the matching thread
+struct ExecutionReport{
+    ReportType type_{ ReportType::Done };
+    CommandType command_{ CommandType::Add };
+    SymbolId symbol_{ 0 };
+    OrderId orderId_{ 0 };
+    std::uint32_t fillCount_{ 0 };
+    std::uint64_t tag_{ 0 };
+    TradeInfo bid_{};
+    TradeInfo ask_{};
+    Event event_{};     // Event reports only
+};
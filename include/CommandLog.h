@@ -0,0 +1,202 @@
+#pragma once
+
+#include "Command.h"
+#include "Order.h"
+#include "OrderModify.h"
+#include "Trade.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Write-ahead command log: a 16-byte header followed by fixed 48-byte
+// records, one per command, in the order the commands were applied.
+//
+// lsn_ numbers commands from 1. eventSeq_ is the book's GetEventSeq() just
+// before the command was applied, i.e. the Event::seq of the first event
+// the command emits, so log records and event journals line up (it stays
+// constant while the book's events are disabled).
+//
+// crc_ is the CRC-32C of the bytes before it. A crash mid-group can leave a
+// partial, zero-filled or garbled tail, so the log ends at the first record
+// that is short, fails its CRC or does not carry the next lsn.
+
+struct CommandLogRecord{
+    std::uint64_t lsn_;
+    std::uint64_t eventSeq_;
+    OrderId orderId_;
+    SymbolId symbol_;
+    Price price_;
+    Quantity quantity_;
+    CommandType type_;
+    std::uint8_t orderType_;    // OrderType
+    std::uint8_t side_;         // Side
+    std::uint8_t reserved_;
+    std::uint32_t crc_;
+    std::uint32_t padding_;
+};
+static_assert(sizeof(CommandLogRecord) == 48, "command log records are fixed-width");
+
+// CRC-32C over a record's fields (everything before crc_)
+std::uint32_t CommandLogRecordCrc(const CommandLogRecord& record);
+
+struct CommandLogHeader{
+    char magic_[8];             // "OMECMDLG"
+    std::uint16_t version_;
+    std::uint16_t recordSize_;
+    std::uint32_t reserved_;
+};
+static_assert(sizeof(CommandLogHeader) == 16, "command log header is fixed-width");
+
+constexpr std::uint16_t CommandLogVersion = 2;
+
+struct CommandLogConfig{
+    // A group is committed (written + fsync'd) once it holds this many
+    // commands, or once its oldest command has waited groupCommitInterval_
+    std::size_t groupCommitCount_{ 64 };
+    std::chrono::microseconds groupCommitInterval_{ 1000 };
+    bool sync_{ true };         // false: write per group but skip fsync
+};
+
+// Single-threaded group-commit log. Append buffers a record; the group is
+// written and fsync'd in one go when it reaches the count or age limit
+// (checked on Append and Poll), or on Commit / Close. A command is durable
+// once DurableLsn() >= its lsn. I/O errors throw std::runtime_error.
+class CommandLog{
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::FILE* file_{ nullptr };
+    CommandLogConfig config_;
+    std::vector<CommandLogRecord> group_;
+    Clock::time_point groupStart_{};
+    std::uint64_t nextLsn_{ 1 };
+    std::uint64_t durableLsn_{ 0 };
+    std::uint64_t commits_{ 0 };
+
+public:
+    CommandLog() = default;
+    CommandLog(const CommandLog&) = delete;
+    CommandLog& operator=(const CommandLog&) = delete;
+    ~CommandLog();
+
+    // Creates (truncates) the log file
+    void Open(const std::string& path, const CommandLogConfig& config = {});
+    void Close();
+    bool IsOpen() const { return file_ != nullptr; }
+
+    // Buffers the command and returns its lsn; may commit the group
+    std::uint64_t Append(const Command& command, std::uint64_t eventSeq);
+    // Commits the group if its age limit has passed (call when idle)
+    void Poll();
+    // Writes and fsyncs everything appended so far
+    void Commit();
+
+    std::uint64_t LastLsn() const { return nextLsn_ - 1; }
+    std::uint64_t DurableLsn() const { return durableLsn_; }
+    std::uint64_t CommitCount() const { return commits_; }
+};
+
+// Sequential reader. The torn tail of a crash mid-write (see above) ends
+// the log; TornTail() reports whether one was dropped.
+class CommandLogReader{
+private:
+    std::FILE* file_{ nullptr };
+    std::vector<CommandLogRecord> chunk_;
+    std::size_t pos_{ 0 };
+    std::size_t count_{ 0 };
+    std::uint64_t nextLsn_{ 1 };
+    bool ended_{ false };
+    bool torn_{ false };
+
+public:
+    explicit CommandLogReader(const std::string& path);
+    CommandLogReader(const CommandLogReader&) = delete;
+    CommandLogReader& operator=(const CommandLogReader&) = delete;
+    ~CommandLogReader();
+
+    bool Next(CommandLogRecord& record);
+    bool TornTail() const { return torn_; }
+};
+
+// Applies a command to any book exposing the sink API
+template <typename Book>
+void ApplyCommand(Book& book, const Command& c, Trades& trades)
+{
+    switch(c.type_){
+    case CommandType::Add:
+        book.AddOrder(Order{ c.orderType_, c.orderId_, c.side_, c.price_, c.quantity_ }, trades);
+        break;
+    case CommandType::Cancel:
+        book.CancelOrder(c.orderId_);
+        break;
+    case CommandType::Modify:
+        book.MatchOrder(OrderModify{ c.orderId_, c.side_, c.price_, c.quantity_ }, trades);
+        break;
+    }
+}
+
+// Write-ahead front end: every command is appended to the log before it is
+// applied to the book. Acknowledge a command to its sender only once
+// Log().DurableLsn() covers the lsn returned here. A command the book
+// refuses (e.g. a price outside a ladder book's band) leaves the book
+// untouched and rethrows, but stays in the log: recovery refuses it again.
+template <typename Book>
+class WriteAheadBook{
+private:
+    Book& book_;
+    CommandLog& log_;
+
+public:
+    WriteAheadBook(Book& book, CommandLog& log) : book_{ book }, log_{ log } {}
+
+    std::uint64_t Apply(const Command& command, Trades& trades){
+        std::uint64_t lsn = log_.Append(command, book_.GetEventSeq());
+        ApplyCommand(book_, command, trades);
+        return lsn;
+    }
+
+    Book& GetBook() { return book_; }
+    CommandLog& Log() { return log_; }
+};
+
+// Replays a command log into a fresh book, up to any torn tail; returns the
+// number of records replayed. Commands the book refuses are skipped, as
+// MatchingThread turns them into a Reject. Throws std::runtime_error if the
+// book's event sequence diverges from the one recorded (the book must have
+// events enabled as it did when the log was written).
+template <typename Book>
+std::uint64_t RecoverCommandLog(Book& book, const std::string& path, Trades& trades)
+{
+    CommandLogReader reader(path);
+    CommandLogRecord r;
+    std::uint64_t replayed = 0;
+    while(reader.Next(r)){
+        if(book.GetEventSeq() != r.eventSeq_){
+            std::ostringstream oss;
+            oss << "Command log (" << path << "): event seq " << book.GetEventSeq()
+                << " does not match record lsn " << r.lsn_ << " (expected " << r.eventSeq_ << ")";
+            throw std::runtime_error(oss.str());
+        }
+        Command c;
+        c.type_ = r.type_;
+        c.symbol_ = r.symbol_;
+        c.orderType_ = static_cast<OrderType>(r.orderType_);
+        c.side_ = static_cast<Side>(r.side_);
+        c.orderId_ = r.orderId_;
+        c.price_ = r.price_;
+        c.quantity_ = r.quantity_;
+        trades.clear();
+        try{
+            ApplyCommand(book, c, trades);
+        }
+        catch(const std::exception&){
+            // Refused when it was first applied too; the book is unchanged
+        }
+        ++replayed;
+    }
+    return replayed;
+}
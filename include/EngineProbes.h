@@ -0,0 +1,171 @@
+#pragma once
+
+#include "TscClock.h"
+#include <cstddef>
+#include <cstdint>
+
+// Compile-time-gated sub-phase probes for the matching hot path. Build with
+// -DOME_ENGINE_PROBES=1 (`make bench_probes`) to enable them; otherwise every
+// probe macro expands to nothing and the book is unchanged.
+//
+// Time is exclusive: entering a phase charges the time since the last
+// transition to the phase being left, so nested probes (a best-price refresh
+// inside a level removal) are never double counted and a bracketed op's
+// phases sum to its duration. Time inside an op but outside any probe goes
+// to EnginePhase::Other. The caller names the op being measured with
+// OME_PROBE_OP_BEGIN / OME_PROBE_OP_END; state is thread-local.
+
+#ifndef OME_ENGINE_PROBES
+#define OME_ENGINE_PROBES 0
+#endif
+
+enum class EnginePhase : std::uint8_t{
+    Other,          // inside the op, outside every probe below
+    Index,          // order-id index lookup / insert / erase
+    Admission,      // IOC crossing check, FOK depth scan
+    LevelInsert,    // level lookup / creation, pool slot, FIFO append
+    LevelRemove,    // FIFO unlink, empty-level erase, pool release
+    MatchLoop,      // crossing loop: fills, trade records, filled-order removal
+    Cleanup,        // cancelling IOC / FOK / market remainders
+    BestPrice,      // top-of-book maintenance
+    Events,         // listener dispatch
+    Count
+};
+
+enum class ProbeOp : std::uint8_t{
+    Add,
+    Cancel,
+    Modify,
+    Query,
+    Match,
+    Count
+};
+
+constexpr const char* EnginePhaseName(EnginePhase phase){
+    switch(phase){
+    case EnginePhase::Other:       return "other";
+    case EnginePhase::Index:       return "index";
+    case EnginePhase::Admission:   return "admission";
+    case EnginePhase::LevelInsert: return "level_insert";
+    case EnginePhase::LevelRemove: return "level_remove";
+    case EnginePhase::MatchLoop:   return "match_loop";
+    case EnginePhase::Cleanup:     return "cleanup";
+    case EnginePhase::BestPrice:   return "best_price";
+    case EnginePhase::Events:      return "events";
+    default:                       return "?";
+    }
+}
+
+constexpr const char* ProbeOpName(ProbeOp op){
+    switch(op){
+    case ProbeOp::Add:    return "add";
+    case ProbeOp::Cancel: return "cancel";
+    case ProbeOp::Modify: return "modify";
+    case ProbeOp::Query:  return "query";
+    case ProbeOp::Match:  return "match";
+    default:              return "?";
+    }
+}
+
+constexpr std::size_t EnginePhaseCount = static_cast<std::size_t>(EnginePhase::Count);
+constexpr std::size_t ProbeOpCount = static_cast<std::size_t>(ProbeOp::Count);
+
+// Raw probe timestamp on the calibrated clock; TscClock::ToNs converts.
+// Unfenced: probes sit back to back inside an op, so fencing each
+// transition would cost more than the phases being split.
+inline std::uint64_t ProbeTicks(){
+    return TscClock::Now();
+}
+
+// Accumulated ticks / entries per (op, phase), plus bracketed op counts
+struct EngineProbeTable{
+    std::uint64_t ticks_[ProbeOpCount][EnginePhaseCount]{};
+    std::uint64_t calls_[ProbeOpCount][EnginePhaseCount]{};
+    std::uint64_t ops_[ProbeOpCount]{};
+};
+
+class EngineProbes{
+private:
+    struct State{
+        EngineProbeTable table_;
+        std::uint64_t last_{ 0 };
+        EnginePhase phase_{ EnginePhase::Other };
+        ProbeOp op_{ ProbeOp::Add };
+        bool active_{ false };
+    };
+
+    static State& Local(){
+        static thread_local State state;
+        return state;
+    }
+
+    static void Charge(State& s, std::uint64_t now){
+        s.table_.ticks_[static_cast<std::size_t>(s.op_)][static_cast<std::size_t>(s.phase_)] += now - s.last_;
+        s.last_ = now;
+    }
+
+public:
+    static void BeginOp(ProbeOp op){
+        State& s = Local();
+        s.op_ = op;
+        s.phase_ = EnginePhase::Other;
+        s.active_ = true;
+        ++s.table_.ops_[static_cast<std::size_t>(op)];
+        s.last_ = ProbeTicks();
+    }
+
+    static void EndOp(){
+        State& s = Local();
+        Charge(s, ProbeTicks());
+        s.active_ = false;
+    }
+
+    // Returns the phase to restore on exit. Cleanup absorbs the probes of
+    // the cancels it issues, so it reports the whole remainder cleanup.
+    static EnginePhase Enter(EnginePhase phase){
+        State& s = Local();
+        EnginePhase outer = s.phase_;
+        if(outer == EnginePhase::Cleanup)
+            return outer;
+        if(s.active_){
+            Charge(s, ProbeTicks());
+            ++s.table_.calls_[static_cast<std::size_t>(s.op_)][static_cast<std::size_t>(phase)];
+        }
+        s.phase_ = phase;
+        return outer;
+    }
+
+    static void Exit(EnginePhase outer){
+        State& s = Local();
+        if(s.active_)
+            Charge(s, ProbeTicks());
+        s.phase_ = outer;
+    }
+
+    static const EngineProbeTable& Table() { return Local().table_; }
+    static void Reset() { Local().table_ = EngineProbeTable{}; }
+};
+
+class EngineProbeScope{
+private:
+    EnginePhase outer_;
+
+public:
+    explicit EngineProbeScope(EnginePhase phase) : outer_{ EngineProbes::Enter(phase) } {}
+    ~EngineProbeScope() { EngineProbes::Exit(outer_); }
+    EngineProbeScope(const EngineProbeScope&) = delete;
+    EngineProbeScope& operator=(const EngineProbeScope&) = delete;
+};
+
+#define OME_PROBE_CONCAT_(a, b) a##b
+#define OME_PROBE_CONCAT(a, b) OME_PROBE_CONCAT_(a, b)
+
+#if OME_ENGINE_PROBES
+  #define OME_PROBE(phase) EngineProbeScope OME_PROBE_CONCAT(omeProbe_, __LINE__){ phase }
+  #define OME_PROBE_OP_BEGIN(op) EngineProbes::BeginOp(op)
+  #define OME_PROBE_OP_END() EngineProbes::EndOp()
+#else
+  #define OME_PROBE(phase) ((void)0)
+  #define OME_PROBE_OP_BEGIN(op) ((void)0)
+  #define OME_PROBE_OP_END() ((void)0)
+#endif
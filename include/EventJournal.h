@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Event.h"
+#include "Orderbook.h"
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Binary event journal: a 16-byte header followed by fixed 40-byte records,
+// one per Event, in emission order. Decode with DecodeEventJournalToCsv
+// (or event_decode.exe) to get the CSV the observers used to write.
+
+struct JournalRecord{
+    std::uint64_t seq_;
+    std::uint64_t orderId_;
+    std::uint64_t orderId2_;
+    Price price_;
+    Quantity quantity_;
+    std::uint8_t type_;
+    std::uint8_t side_;
+    std::uint8_t reserved_[6];
+};
+static_assert(sizeof(JournalRecord) == 40, "journal records are fixed-width");
+
+struct JournalHeader{
+    char magic_[8];             // "OMEEVENT"
+    std::uint16_t version_;
+    std::uint16_t recordSize_;
+    std::uint32_t reserved_;
+};
+static_assert(sizeof(JournalHeader) == 16, "journal header is fixed-width");
+
+constexpr std::uint16_t JournalVersion = 1;
+
+// Appends events into a preallocated buffer and writes it out in bulk when
+// it fills. With background flushing the full buffer is handed to a flusher
+// thread and appends continue into a second buffer, so the appending thread
+// only waits if it fills a buffer before the previous one is on disk.
+// Append is single-threaded. I/O errors surface as std::runtime_error from
+// Close.
+class EventJournal{
+private:
+    std::FILE* file_{ nullptr };
+    std::vector<JournalRecord> active_;
+    std::size_t used_{ 0 };
+    std::uint64_t appended_{ 0 };
+    bool failed_{ false };
+
+    // Background flushing: pending_ is owned by the flusher while pendingFull_
+    bool background_{ false };
+    std::vector<JournalRecord> pending_;
+    std::size_t pendingCount_{ 0 };
+    bool pendingFull_{ false };
+    bool stop_{ false };
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread flusher_;
+
+    void Rotate();
+    void WriteRecords(const JournalRecord* records, std::size_t count);
+    void FlushLoop();
+
+public:
+    static constexpr std::size_t DefaultCapacity = 1u << 16;
+
+    EventJournal() = default;
+    EventJournal(const EventJournal&) = delete;
+    EventJournal& operator=(const EventJournal&) = delete;
+    ~EventJournal();
+
+    void Open(const std::string& path, std::size_t capacityRecords = DefaultCapacity, bool backgroundFlush = false);
+    // Writes everything still buffered and closes the file
+    void Close();
+    bool IsOpen() const { return file_ != nullptr; }
+    std::uint64_t RecordCount() const { return appended_; }
+
+    void Append(const Event& e){
+        if(used_ == active_.size())
+            Rotate();
+        JournalRecord& r = active_[used_++];
+        r.seq_ = e.seq;
+        r.orderId_ = e.order_id;
+        r.orderId2_ = e.order_id2;
+        r.price_ = e.price;
+        r.quantity_ = e.qty;
+        r.type_ = e.type;
+        r.side_ = e.side;
+        ++appended_;
+    }
+};
+
+// Compile-time listener writing straight into a journal (no type erasure)
+class JournalEventListener{
+private:
+    EventJournal* journal_{ nullptr };
+
+public:
+    JournalEventListener() = default;
+    explicit JournalEventListener(EventJournal* journal) : journal_{ journal } {}
+
+    bool Enabled() const { return journal_ != nullptr; }
+    void OnEvent(const Event& e) { journal_->Append(e); }
+};
+
+extern template class BasicOrderbook<JournalEventListener>;
+
+using JournaledOrderbook = BasicOrderbook<JournalEventListener>;
+
+// Renders a journal as "# columns=..." plus one Event::to_csv() line per
+// record; returns the record count. Throws std::runtime_error on I/O errors.
+std::uint64_t DecodeEventJournalToCsv(const std::string& journalPath, const std::string& csvPath);
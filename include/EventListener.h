@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Event.h"
+#include <utility>
+
+// Event listeners plug into BasicOrderbook at compile time. A listener
+// provides Enabled() (checked before an event is built) and OnEvent().
+// When Enabled() is a constant false, event construction compiles away.
+
+// Drops every event; the book carries no event overhead at all
+struct NullEventListener{
+    static constexpr bool Enabled() { return false; }
+    void OnEvent(const Event&) {}
+};
+
+// Type-erased adapter behind Orderbook::SetObserver / EnableEvents
+class ObserverEventListener{
+private:
+    EventObserver observer_;
+    bool enabled_{ false };
+
+public:
+    bool Enabled() const { return enabled_; }
+    void OnEvent(const Event& e) { if (observer_) observer_(e); }
+
+    void SetObserver(EventObserver obs) { observer_ = std::move(obs); }
+    void Enable(bool enabled) { enabled_ = enabled; }
+};
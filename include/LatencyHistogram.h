@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// Fixed-memory log-linear histogram (HDR-style) for latency samples.
+// Values below 2^SubBucketBits are counted exactly; each power-of-two range
+// above that is split into 2^(SubBucketBits - 1) equal sub-buckets, so a
+// reported value is within 2^-(SubBucketBits - 1) of the recorded one
+// (0.8% at the default 8 bits). Values of 2^MaxValueBits and more share the
+// top bucket; Max() is always exact. Record is a handful of integer ops and
+// never allocates, so histograms can stay on in production paths.
+template <unsigned SubBucketBits = 8, unsigned MaxValueBits = 40>
+class LogLinearHistogram{
+    static_assert(SubBucketBits >= 2 && SubBucketBits < MaxValueBits && MaxValueBits <= 63,
+                  "histogram needs 2 <= SubBucketBits < MaxValueBits <= 63");
+
+    static constexpr std::uint64_t HalfBucket = std::uint64_t{ 1 } << (SubBucketBits - 1);
+    static constexpr unsigned MaxShift = MaxValueBits - SubBucketBits;
+
+public:
+    static constexpr std::size_t BucketCount = (MaxShift + 2) * HalfBucket;
+
+private:
+    std::array<std::uint64_t, BucketCount> counts_{};
+    std::uint64_t total_{ 0 };
+    std::uint64_t min_{ std::numeric_limits<std::uint64_t>::max() };
+    std::uint64_t max_{ 0 };
+
+    static std::size_t IndexOf(std::uint64_t value){
+        unsigned width = static_cast<unsigned>(std::bit_width(value));
+        unsigned shift = width > SubBucketBits ? width - SubBucketBits : 0;
+        if(shift > MaxShift)
+            return BucketCount - 1;
+        return shift * HalfBucket + (value >> shift);
+    }
+
+    static unsigned ShiftOf(std::size_t index){
+        return index < 2 * HalfBucket ? 0 : static_cast<unsigned>(index / HalfBucket - 1);
+    }
+
+public:
+    void Record(std::uint64_t value){
+        ++counts_[IndexOf(value)];
+        ++total_;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    void Merge(const LogLinearHistogram& other){
+        for(std::size_t i = 0; i < BucketCount; ++i)
+            counts_[i] += other.counts_[i];
+        total_ += other.total_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    void Reset() { *this = LogLinearHistogram{}; }
+
+    std::uint64_t Count() const { return total_; }
+    std::uint64_t Min() const { return total_ ? min_ : 0; }
+    std::uint64_t Max() const { return max_; }
+
+    // Value range [BucketLow, BucketHigh] counted by bucket i
+    static std::uint64_t BucketLow(std::size_t index){
+        unsigned shift = ShiftOf(index);
+        return static_cast<std::uint64_t>(index - shift * HalfBucket) << shift;
+    }
+    static std::uint64_t BucketHigh(std::size_t index){
+        return BucketLow(index) + (std::uint64_t{ 1 } << ShiftOf(index)) - 1;
+    }
+
+    // Smallest bucket bound covering fraction p (0..1) of the samples,
+    // capped at the exact maximum; 0 when empty
+    std::uint64_t Percentile(double p) const {
+        if(total_ == 0)
+            return 0;
+        if(p >= 1.0)
+            return max_;
+        std::uint64_t target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(p * static_cast<double>(total_))));
+        std::uint64_t seen = 0;
+        for(std::size_t i = 0; i < BucketCount; ++i){
+            seen += counts_[i];
+            if(seen >= target)
+                return std::min(BucketHigh(i), max_);
+        }
+        return max_;
+    }
+
+    // Visits non-empty buckets in value order: fn(low, high, count)
+    template <typename Fn>
+    void ForEachBucket(Fn&& fn) const {
+        for(std::size_t i = 0; i < BucketCount; ++i){
+            if(counts_[i])
+                fn(BucketLow(i), BucketHigh(i), counts_[i]);
+        }
+    }
+};
+
+using LatencyHistogram = LogLinearHistogram<>;
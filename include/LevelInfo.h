@@ -1,11 +1,13 @@
 #pragma once
 
 #include "Usings.h"
+#include <cstdint>
 #include <vector>
 
 struct LevelInfo{
     Price price_;
     Quantity quantity_;
+    std::uint32_t orderCount_{ 0 };
 };
 
 using LevelInfos = std::vector<LevelInfo>;
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "MatchingThread.h"
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <vector>
+
+struct MatchingEngineConfig{
+    OrderbookConfig book_{};    // applied to every symbol's book
+    std::size_t shardCount_{ 1 };
+    std::size_t inboundCapacity_{ 1u << 14 };   // per shard
+    std::size_t outboundCapacity_{ 1u << 14 };  // per shard
+    int firstCpu_{ -1 };        // shard i is pinned to firstCpu_ + i; -1 leaves shards floating
+    bool events_{ false };      // shards publish book events as Event reports
+};
+
+// Multi-symbol engine: symbols are partitioned across shards, each shard a
+// MatchingThread that exclusively owns its symbols' books, so matching
+// takes no locks. A single gateway thread routes commands with TrySubmit and
+// a single consumer thread (possibly the same) drains reports with TryPoll.
+// Reports for one symbol arrive in command order; reports from different
+// shards interleave arbitrarily.
+class MatchingEngine{
+private:
+    static constexpr std::uint32_t NoShard = std::numeric_limits<std::uint32_t>::max();
+
+    MatchingEngineConfig config_;
+    std::vector<std::unique_ptr<MatchingThread>> shards_;
+    // Indexed by symbol id
+    std::vector<std::uint32_t> shardOf_;
+    std::size_t symbolCount_{ 0 };
+    std::size_t pollCursor_{ 0 };
+
+public:
+    explicit MatchingEngine(const MatchingEngineConfig& config);
+    MatchingEngine(const MatchingEngine&) = delete;
+    MatchingEngine& operator=(const MatchingEngine&) = delete;
+    ~MatchingEngine();
+
+    // Registers a symbol before Start. Without an explicit shard, symbols
+    // are dealt round-robin in registration order, so registering the most
+    // active symbols first spreads them across shards.
+    void AddSymbol(SymbolId symbol);
+    void AddSymbol(SymbolId symbol, std::size_t shard);
+
+    void Start();
+    // Drains every submitted command, then joins all shards
+    void Stop();
+
+    // Gateway side; false when the owning shard's ring is full. Throws
+    // std::logic_error for a symbol that was never added.
+    bool TrySubmit(const Command& command);
+    // Consumer side; polls shards round-robin
+    bool TryPoll(ExecutionReport& report);
+
+    std::size_t ShardCount() const { return shards_.size(); }
+    std::size_t SymbolCount() const { return symbolCount_; }
+    std::size_t ShardOf(SymbolId symbol) const;
+
+    // Only safe to inspect while stopped
+    const MatchingThread::Book& GetBook(SymbolId symbol) const;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Command.h"
+#include "Orderbook.h"
+#include "SpscRing.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct MatchingThreadConfig{
+    OrderbookConfig book_{};    // applied to every book the thread owns
+    std::size_t inboundCapacity_{ 1u << 16 };
+    std::size_t outboundCapacity_{ 1u << 16 };
+    int cpu_{ -1 };     // core to pin the matching thread to; -1 leaves it floating
+    bool events_{ false };  // also publish every book event as an Event report
+};
+
+class MatchingThread;
+
+// Compile-time listener publishing each book event as an Event report on
+// the owning thread's outbound ring; null thread means events are off
+class ReportEventListener{
+private:
+    MatchingThread* thread_{ nullptr };
+
+public:
+    ReportEventListener() = default;
+    explicit ReportEventListener(MatchingThread* thread) : thread_{ thread } {}
+
+    bool Enabled() const { return thread_ != nullptr; }
+    void OnEvent(const Event& e);
+};
+
+extern template class BasicOrderbook<ReportEventListener>;
+
+// Owns one book per registered symbol and a thread that drains commands from
+// an SPSC ingress ring, matches them, and publishes fills plus a per-command
+// Done report through an SPSC outbound ring. With events_ set, the book's
+// events (add / cancel / trade / modify, as the observer API sees them) are
+// published as Event reports while the command runs, ahead of its fills.
+// Commands for a symbol with no book here, or that the book throws on, get a
+// Reject report ahead of their Done. Exactly one producer thread may call TrySubmit and
+// exactly one consumer thread may call TryPoll (they can be the same thread).
+//
+// The matching thread waits for outbound space rather than dropping
+// reports, so the consumer must keep polling while commands are in flight.
+class MatchingThread{
+public:
+    using Book = BasicOrderbook<ReportEventListener>;
+
+private:
+    OrderbookConfig bookConfig_;
+    // Indexed by symbol id; null where the symbol lives elsewhere
+    std::vector<std::unique_ptr<Book>> books_;
+    SpscRing<Command> inbound_;
+    SpscRing<ExecutionReport> outbound_;
+    Trades fills_;
+    int cpu_;
+    bool events_;
+    // Report being built for the command in flight; event reports copy it
+    const ExecutionReport* current_{ nullptr };
+
+    std::thread thread_;
+    std::atomic<bool> running_{ false };
+
+    void Run();
+    void Process(const Command& command);
+    void Publish(const ExecutionReport& report);
+    void PublishEvent(const Event& event);
+
+    friend class ReportEventListener;
+
+public:
+    explicit MatchingThread(const MatchingThreadConfig& config);
+    MatchingThread(const MatchingThread&) = delete;
+    MatchingThread& operator=(const MatchingThread&) = delete;
+    ~MatchingThread();
+
+    // Creates the symbol's book; only valid before Start
+    void AddSymbol(SymbolId symbol);
+    bool HasSymbol(SymbolId symbol) const { return symbol < books_.size() && books_[symbol]; }
+
+    void Start();
+    // Processes every command already submitted, then joins the thread
+    void Stop();
+    bool Running() const { return running_.load(std::memory_order_relaxed); }
+
+    // Producer side; false when the ingress ring is full
+    bool TrySubmit(const Command& command) { return inbound_.TryPush(command); }
+    // Consumer side; false when no report is pending
+    bool TryPoll(ExecutionReport& report) { return outbound_.TryPop(report); }
+
+    // Only safe to inspect while the thread is stopped
+    const Book& GetBook(SymbolId symbol) const { return *books_.at(symbol); }
+};
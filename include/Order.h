@@ -7,18 +7,20 @@
 #include <memory>
 #include <list>
 
+// Widest fields first: 24 bytes, so a pool slot with its links and level
+// pointer fits in one 64-byte cache line (see OrderNode in OrderPool.h)
 class Order{
 private:
-    OrderType orderType_;
     OrderId orderId_;
-    Side side_;
     Price price_;
     Quantity initialQuantity_;
     Quantity remainingQuantity_;
+    OrderType orderType_;
+    Side side_;
 
 public:
     Order(OrderType orderType, OrderId orderId, Side side, Price price, Quantity quantity) : 
-        orderType_{ orderType }, orderId_{ orderId }, side_{ side }, price_{ price }, initialQuantity_{ quantity }, remainingQuantity_{ quantity }
+        orderId_{ orderId }, price_{ price }, initialQuantity_{ quantity }, remainingQuantity_{ quantity }, orderType_{ orderType }, side_{ side }
     {}
 
     OrderType GetOrderType() const { return orderType_; }
@@ -38,6 +40,17 @@ public:
         remainingQuantity_ -= quantity;
     }
 
+    // In-place size reduction (modify): the filled amount is unchanged
+    void ReduceTo(Quantity remaining){
+        if(remaining > GetRemainingQuantity()){
+            std::ostringstream oss;
+            oss << "Order (" << GetOrderId() << ") can only be reduced in place";
+            throw std::logic_error(oss.str());
+        }
+        initialQuantity_ -= remainingQuantity_ - remaining;
+        remainingQuantity_ = remaining;
+    }
+
     void ToImmediateOrCancel(Price price){
         if(price <= 0){
             std::ostringstream oss;
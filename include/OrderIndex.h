@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Usings.h"
+#include "OrderPool.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+// Flat open-addressing map OrderId -> OrderHandle (linear probing, backward
+// shift deletion, no tombstones). Sized for the reserved capacity at a load
+// factor of at most 1/2 and only rehashes when that capacity is exceeded.
+class OrderIndex{
+private:
+    struct Slot{
+        OrderId orderId_{ 0 };
+        OrderHandle handle_{ InvalidOrderHandle };   // InvalidOrderHandle marks an empty slot
+    };
+
+    std::vector<Slot> slots_;
+    std::size_t mask_{ 0 };
+    unsigned bits_{ 0 };
+    std::size_t size_{ 0 };
+
+    // Ids are mostly sequential, so runs of RunLength consecutive ids keep
+    // consecutive slots (2 KB, cache / TLB locality), while the runs
+    // themselves are scattered by a multiplicative hash: dense id ranges far
+    // apart (e.g. 10.. and 1'000'000..) must not wrap onto each other's
+    // slots and merge into one long probe cluster
+    static constexpr unsigned RunBits = 7;
+    static constexpr std::size_t RunLength = std::size_t{ 1 } << RunBits;
+
+    std::size_t Home(OrderId orderId) const {
+        std::uint64_t run = (orderId >> RunBits) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<std::size_t>(run >> (64 - (bits_ - RunBits))) << RunBits
+             | static_cast<std::size_t>(orderId & (RunLength - 1));
+    }
+
+    void Allocate(std::size_t capacity){
+        std::size_t buckets = std::bit_ceil(std::max(capacity * 2, 2 * RunLength));
+        slots_.assign(buckets, Slot{});
+        mask_ = buckets - 1;
+        bits_ = static_cast<unsigned>(std::countr_zero(buckets));
+        size_ = 0;
+    }
+
+    void Grow(){
+        std::vector<Slot> old;
+        old.swap(slots_);
+        Allocate(old.size());
+        for(const Slot& slot : old){
+            if(slot.handle_ != InvalidOrderHandle)
+                Insert(slot.orderId_, slot.handle_);
+        }
+    }
+
+public:
+    explicit OrderIndex(std::size_t capacity = 0) { Allocate(capacity); }
+
+    std::size_t Size() const { return size_; }
+    bool Empty() const { return size_ == 0; }
+
+    OrderHandle Find(OrderId orderId) const {
+        for(std::size_t i = Home(orderId); ; i = (i + 1) & mask_){
+            const Slot& slot = slots_[i];
+            if(slot.handle_ == InvalidOrderHandle)
+                return InvalidOrderHandle;
+            if(slot.orderId_ == orderId)
+                return slot.handle_;
+        }
+    }
+
+    bool Contains(OrderId orderId) const { return Find(orderId) != InvalidOrderHandle; }
+
+    // Longest probe sequence any indexed id needs (slots visited, diagnostics)
+    std::size_t MaxProbeLength() const {
+        std::size_t longest = 0;
+        for(std::size_t i = 0; i < slots_.size(); ++i){
+            if(slots_[i].handle_ != InvalidOrderHandle)
+                longest = std::max(longest, ((i - Home(slots_[i].orderId_)) & mask_) + 1);
+        }
+        return longest;
+    }
+
+    // Pulls the id's home slot into cache ahead of a lookup or insert
+    void Prefetch(OrderId orderId) const { __builtin_prefetch(&slots_[Home(orderId)]); }
+
+    // Inserts if absent; returns false when the id is already indexed
+    bool Insert(OrderId orderId, OrderHandle handle){
+        if((size_ + 1) * 2 > slots_.size())
+            Grow();
+        for(std::size_t i = Home(orderId); ; i = (i + 1) & mask_){
+            Slot& slot = slots_[i];
+            if(slot.handle_ == InvalidOrderHandle){
+                slot.orderId_ = orderId;
+                slot.handle_ = handle;
+                ++size_;
+                return true;
+            }
+            if(slot.orderId_ == orderId)
+                return false;
+        }
+    }
+
+    // Find-and-erase in a single probe sequence; returns the removed handle
+    // or InvalidOrderHandle if the id was not indexed
+    OrderHandle Extract(OrderId orderId){
+        std::size_t i = Home(orderId);
+        while(true){
+            if(slots_[i].handle_ == InvalidOrderHandle)
+                return InvalidOrderHandle;
+            if(slots_[i].orderId_ == orderId)
+                break;
+            i = (i + 1) & mask_;
+        }
+        OrderHandle handle = slots_[i].handle_;
+
+        // shift following entries of the cluster back so lookups need no tombstones
+        for(std::size_t j = (i + 1) & mask_; slots_[j].handle_ != InvalidOrderHandle; j = (j + 1) & mask_){
+            std::size_t home = Home(slots_[j].orderId_);
+            if(((j - home) & mask_) >= ((j - i) & mask_)){
+                slots_[i] = slots_[j];
+                i = j;
+            }
+        }
+        slots_[i] = Slot{};
+        --size_;
+        return handle;
+    }
+};
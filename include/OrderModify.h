@@ -23,6 +23,10 @@ public:
     Price GetPrice() const { return price_; }
     Quantity GetQuantity() const { return quantity_; }
     
+    Order ToOrder(OrderType type) const {
+        return Order{type, GetOrderId(), GetSide(), GetPrice(), GetQuantity()};
+    }
+
     OrderPointer ToOrderPointer(OrderType type) const {
         return std::make_shared<Order>(type, GetOrderId(), GetSide(), GetPrice(), GetQuantity());
     }
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Order.h"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Index of an order slot in the OrderPool; stable for the order's lifetime
+using OrderHandle = std::uint32_t;
+constexpr OrderHandle InvalidOrderHandle = std::numeric_limits<OrderHandle>::max();
+
+struct PriceLevel;
+
+// Pool slot: the order plus intrusive links to its neighbours in the price
+// level FIFO (or the next free slot while unused) and the level it rests
+// on, so removing it needs no price lookup. Everything a cancel reads after
+// the index probe (side, price, quantity, links, level) is in this slot,
+// and cache-line alignment keeps it in one line: packed at 40 bytes, 3 in
+// 8 slots would straddle two.
+struct alignas(64) OrderNode{
+    Order order_;
+    OrderHandle prev_{ InvalidOrderHandle };
+    OrderHandle next_{ InvalidOrderHandle };
+    PriceLevel* level_{ nullptr };
+};
+static_assert(sizeof(OrderNode) == 64, "order pool slot outgrew a cache line; keep Order's fields packed");
+
+// Slab of order slots recycled through a free list. Slots are addressed by
+// index, so growing the slab never invalidates handles; once the slab has
+// reached its working size, Allocate/Release never touch the heap.
+class OrderPool{
+private:
+    std::vector<OrderNode> nodes_;
+    OrderHandle freeHead_{ InvalidOrderHandle };
+    std::size_t live_{ 0 };
+
+public:
+    explicit OrderPool(std::size_t capacity = 0) { nodes_.reserve(capacity); }
+
+    OrderHandle Allocate(const Order& order){
+        ++live_;
+        if(freeHead_ != InvalidOrderHandle){
+            OrderHandle handle = freeHead_;
+            OrderNode& node = nodes_[handle];
+            freeHead_ = node.next_;
+            node = OrderNode{ order };
+            return handle;
+        }
+        nodes_.push_back(OrderNode{ order });
+        return static_cast<OrderHandle>(nodes_.size() - 1);
+    }
+
+    void Release(OrderHandle handle){
+        --live_;
+        nodes_[handle].prev_ = InvalidOrderHandle;
+        nodes_[handle].next_ = freeHead_;
+        freeHead_ = handle;
+    }
+
+    OrderNode& Node(OrderHandle handle) { return nodes_[handle]; }
+    const OrderNode& Node(OrderHandle handle) const { return nodes_[handle]; }
+    Order& Get(OrderHandle handle) { return nodes_[handle].order_; }
+    const Order& Get(OrderHandle handle) const { return nodes_[handle].order_; }
+
+    void Prefetch(OrderHandle handle) const { __builtin_prefetch(&nodes_[handle]); }
+
+    std::size_t Size() const { return live_; }
+    std::size_t Capacity() const { return nodes_.capacity(); }
+};
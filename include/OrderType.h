@@ -1,6 +1,8 @@
 #pragma once
 
-enum class OrderType{
+#include <cstdint>
+
+enum class OrderType : std::uint8_t{
     FillOrKill,
     GoodTillCancel,
     ImmediateOrCancel,
@@ -7,60 +7,140 @@
 #include "OrderModify.h"
 #include "OrderbookLevelInfos.h"
 #include "Event.h"
-#include <map>
-#include <unordered_map>
+#include "EventListener.h"
+#include "OrderbookConfig.h"
+#include "BookSide.h"
+#include "OrderPool.h"
+#include "OrderIndex.h"
+#include "OrderbookSnapshot.h"
+#include "Command.h"
+#include <concepts>
+#include <span>
+#include <string>
+#include <vector>
 
-class Orderbook{
+// Order book parameterised on its event listener (see EventListener.h).
+// Member definitions live in Orderbook.inl; each listener's instantiation
+// sits with the listener (Orderbook.cpp for the two declared at the bottom
+// of this header), so a plain book links without the journal or the thread.
+template <typename Listener>
+class BasicOrderbook{
 private:
-    struct OrderEntry{
-        OrderPointer order_{ nullptr };
-        OrderPointers::iterator location_;
-    };
-
-    std::map<Price, OrderPointers, std::greater<Price>> bids_;
-    std::map<Price, OrderPointers, std::less<Price>> asks_;
-    std::unordered_map<OrderId, OrderEntry> orders_;
+    // Resting orders live in the pool; levels link them intrusively
+    OrderPool pool_;
+    BookSide<Side::Buy> bids_;
+    BookSide<Side::Sell> asks_;
+    OrderIndex orders_;
 
     size_t matchedOrders_ = 0;
+    // Top of book, maintained incrementally: set when a better level is
+    // added, re-read from the side only when the best level is erased.
+    // Level pointers stay valid while the level exists (map nodes and
+    // ladder slots never move).
     Price bestBid_{0};
     Price bestAsk_{0};
+    const PriceLevel* bestBidLevel_{ nullptr };
+    const PriceLevel* bestAskLevel_{ nullptr };
     
     Side lastAggressorSide_{ Side::Buy };
 
+    // IOC / Market / FOK orders admitted by the current aggressor; their
+    // unfilled remainder is cancelled at the end of MatchOrders
+    std::vector<OrderId> transientOrders_;
+
     bool CanFullyFill(Side side, Price price, Quantity quantity) const;
     bool CanFullyFill_Buy(Price price, Quantity quantity) const;
     bool CanFullyFill_Sell(Price price, Quantity quantity) const;
     bool CanMatch(Side side, Price price) const;
+    void RemoveOrder(OrderHandle handle);
+    // Same side and price with no more quantity: the modify shrinks the
+    // resting order in place instead of cancelling / replacing it
+    static bool InPlaceModify(const Order& resting, const OrderModify& order);
+    // Rests an admissible order (emits ADD); false if it was rejected
+    bool AdmitOrder(const Order& incoming);
+    bool Crossed() const { return bestBidLevel_ && bestAskLevel_ && bestBid_ >= bestAsk_; }
+    void RefreshBestBid();
+    void RefreshBestAsk();
 
-    EventObserver observer_;
+    Listener listener_;
     void EmitEvent(const Event &e);
     uint64_t event_seq_{0}; 
-    bool events_enabled_{false};
 
 public:
-    Orderbook();
-    Orderbook(const Orderbook& ) = delete;
-    void operator=(const Orderbook& ) = delete;
-    Orderbook(Orderbook&&) = delete;
-    void operator=(Orderbook&&) = delete;
-    ~Orderbook();
+    BasicOrderbook();
+    explicit BasicOrderbook(const OrderbookConfig& config, Listener listener = Listener{});
+    BasicOrderbook(const BasicOrderbook& ) = delete;
+    void operator=(const BasicOrderbook& ) = delete;
+    BasicOrderbook(BasicOrderbook&&) = delete;
+    void operator=(BasicOrderbook&&) = delete;
+    ~BasicOrderbook();
 
+    Trades AddOrder(const Order& order);
     Trades AddOrder(OrderPointer order);
     void CancelOrder(OrderId orderId);
     Trades MatchOrder(OrderModify order);
     Trades MatchOrders();
 
+    // Sink variants: fills are appended to a caller-owned buffer, so a
+    // buffer reused across calls makes the matching path allocation-free
+    void AddOrder(const Order& order, Trades& trades);
+    void MatchOrder(OrderModify order, Trades& trades);
+    void MatchOrders(Trades& trades);
+
+    // Applies adds / cancels / modifies in order with the same results and
+    // events as the single-command calls (symbol_ and tag_ are ignored);
+    // fills of the whole batch are appended to trades in order. Index and
+    // pool slots are prefetched a few commands ahead, and the matching pass
+    // is skipped when the cached top of book shows nothing can cross.
+    void ProcessBatch(std::span<const Command> commands, Trades& trades);
+
+    // Resting order with this id, or nullptr; valid until the next mutation
+    const Order* FindOrder(OrderId orderId) const;
+    // Whether MatchOrder(order) would take the in-place path (false if the
+    // order is not resting)
+    bool ModifiesInPlace(const OrderModify& order) const;
+
     // Size of Orderbook
     size_t Size() const;    
     size_t GetMatchedOrders() const;
 
     Price GetBestBidPrice() const;
     Price GetBestAskPrice() const;
+    // Remaining quantity resting at the best level (0 if the side is empty)
+    Quantity GetBestBidQuantity() const;
+    Quantity GetBestAskQuantity() const;
+    // Full recompute of the top of book (mutations keep it current already)
     void UpdateBestPrices();
 
     OrderbookLevelInfos GetOrderInfos() const;
 
-    // register an event observer
-    void SetObserver(EventObserver obs);
-    void EnableEvents(bool enabled);
-};
\ No newline at end of file
+    // Sequence number the next event will carry
+    uint64_t GetEventSeq() const { return event_seq_; }
+
+    // Full-state persistence (layout in OrderbookSnapshot.h): every resting
+    // order with its FIFO position, matched-order count, event sequence and
+    // last aggressor side. LoadSnapshot requires an empty book and emits no
+    // events. Both throw std::runtime_error on I/O or format errors; a book
+    // whose load failed must be discarded.
+    void SaveSnapshot(const std::string& path) const;
+    void LoadSnapshot(const std::string& path);
+
+    Listener& GetListener() { return listener_; }
+
+    // register an event observer (type-erased listener only)
+    void SetObserver(EventObserver obs) requires std::same_as<Listener, ObserverEventListener>
+    {
+        listener_.SetObserver(std::move(obs));
+    }
+
+    void EnableEvents(bool enabled) requires std::same_as<Listener, ObserverEventListener>
+    {
+        listener_.Enable(enabled);
+    }
+};
+
+extern template class BasicOrderbook<NullEventListener>;
+extern template class BasicOrderbook<ObserverEventListener>;
+
+// Default book: events routed through a runtime-settable std::function
+using Orderbook = BasicOrderbook<ObserverEventListener>;
\ No newline at end of file
@@ -0,0 +1,640 @@
+#pragma once
+
+// Member definitions of BasicOrderbook, included only by the translation
+// unit that explicitly instantiates the book for a listener: Orderbook.cpp
+// (Null / Observer), EventJournal.cpp (Journal), MatchingThread.cpp (Report).
+#include "Orderbook.h"
+#include "EngineProbes.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+template <typename Listener>
+BasicOrderbook<Listener>::BasicOrderbook() : BasicOrderbook(OrderbookConfig{}) {}
+
+template <typename Listener>
+BasicOrderbook<Listener>::BasicOrderbook(const OrderbookConfig& config, Listener listener)
+    : pool_{ config.orderCapacity_ }
+    , bids_{ config }
+    , asks_{ config }
+    , orders_{ config.orderCapacity_ }
+    , listener_{ std::move(listener) }
+{
+    transientOrders_.reserve(4);
+}
+
+template <typename Listener>
+BasicOrderbook<Listener>::~BasicOrderbook(){}
+
+template <typename Listener>
+void BasicOrderbook<Listener>::EmitEvent(const Event &e) {
+    OME_PROBE(EnginePhase::Events);
+    listener_.OnEvent(e);
+}
+
+template <typename Listener>
+Price BasicOrderbook<Listener>::GetBestBidPrice() const 
+{
+    return bestBid_; 
+}
+
+template <typename Listener>
+Price BasicOrderbook<Listener>::GetBestAskPrice() const 
+{ 
+    return bestAsk_; 
+}
+
+template <typename Listener>
+Quantity BasicOrderbook<Listener>::GetBestBidQuantity() const
+{
+    return bestBidLevel_ ? bestBidLevel_->GetQuantity() : 0;
+}
+
+template <typename Listener>
+Quantity BasicOrderbook<Listener>::GetBestAskQuantity() const
+{
+    return bestAskLevel_ ? bestAskLevel_->GetQuantity() : 0;
+}
+
+template <typename Listener>
+void BasicOrderbook<Listener>::RefreshBestBid() {
+    OME_PROBE(EnginePhase::BestPrice);
+    bool empty = bids_.Empty();
+    bestBid_ = empty ? 0 : bids_.BestPrice();
+    bestBidLevel_ = empty ? nullptr : &bids_.BestLevel();
+}
+
+template <typename Listener>
+void BasicOrderbook<Listener>::RefreshBestAsk() {
+    OME_PROBE(EnginePhase::BestPrice);
+    bool empty = asks_.Empty();
+    bestAsk_ = empty ? 0 : asks_.BestPrice();
+    bestAskLevel_ = empty ? nullptr : &asks_.BestLevel();
+}
+
+template <typename Listener>
+void BasicOrderbook<Listener>::UpdateBestPrices() {
+    RefreshBestBid();
+    RefreshBestAsk();
+}
+
+template <typename Listener>
+bool BasicOrderbook<Listener>::CanFullyFill_Buy(Price price, Quantity quantity) const 
+{   
+    Quantity available = 0;
+    bool fillable = false;
+    asks_.ForEachLevel([&](Price levelPrice, const PriceLevel& level){
+        if(levelPrice > price)
+            return false;
+        available += level.GetQuantity();
+        fillable = (quantity <= available);
+        return !fillable;
+    });
+    return fillable;
+}
+
+template <typename Listener>
+bool BasicOrderbook<Listener>::CanFullyFill_Sell(Price price, Quantity quantity) const 
+{   
+    Quantity available = 0;
+    bool fillable = false;
+    bids_.ForEachLevel([&](Price levelPrice, const PriceLevel& level){
+        if(levelPrice < price)
+            return false;
+        available += level.GetQuantity();
+        fillable = (quantity <= available);
+        return !fillable;
+    });
+    return fillable;
+}
+
+template <typename Listener>
+bool BasicOrderbook<Listener>::CanFullyFill(Side side, Price price, Quantity quantity) const 
+{
+    if(!CanMatch(side, price))
+        return false;
+
+    if(side == Side::Buy)
+        return CanFullyFill_Buy(price, quantity);
+    else    
+        return CanFullyFill_Sell(price, quantity);
+}
+
+// Unlinks a resting order from its level and returns its slot to the pool
+template <typename Listener>
+void BasicOrderbook<Listener>::RemoveOrder(OrderHandle handle)
+{
+    OME_PROBE(EnginePhase::LevelRemove);
+    // the node's level pointer replaces a price lookup (a map descent)
+    const OrderNode& node = pool_.Node(handle);
+    Price price = node.order_.GetPrice();
+    PriceLevel& level = *node.level_;
+    level.Erase(pool_, handle);
+    if(level.Empty()){
+        if(node.order_.GetSide() == Side::Buy){
+            bids_.EraseLevel(price);
+            if(price == bestBid_)
+                RefreshBestBid();
+        }
+        else{
+            asks_.EraseLevel(price);
+            if(price == bestAsk_)
+                RefreshBestAsk();
+        }
+    }
+    pool_.Release(handle);
+}
+
+template <typename Listener>
+void BasicOrderbook<Listener>::CancelOrder(OrderId orderId)
+{
+    OrderHandle handle;
+    {
+        OME_PROBE(EnginePhase::Index);
+        handle = orders_.Extract(orderId);
+    }
+    if(handle == InvalidOrderHandle)
+        return ;
+
+    // <<<<<< EVENT: CANCEL
+    if (listener_.Enabled()) 
+    {
+        const Order& order = pool_.Get(handle);
+        Event ev;
+        ev.type = Event::EVT_CANCEL;
+        // assign deterministic sequence
+        ev.seq = event_seq_++;
+        ev.order_id = orderId;          // the canceled order id
+        ev.order_id2 = 0;
+        ev.price = order.GetPrice();
+        ev.qty = order.GetRemainingQuantity();  // optional: canceled quantity if tracked
+        ev.side = (order.GetSide() == Side::Buy) ? 1 : 0;
+        EmitEvent(ev);
+    }
+    RemoveOrder(handle);
+}
+
+template <typename Listener>
+bool BasicOrderbook<Listener>::CanMatch(Side side, Price price) const {
+    if(side == Side::Buy){
+        if(!bestAskLevel_) return false;
+        return price >= bestAsk_;
+    }
+    else if(side == Side::Sell){
+        if(!bestBidLevel_) return false;
+        return price <= bestBid_;
+    }
+    return false;
+}
+
+template <typename Listener>
+Trades BasicOrderbook<Listener>::MatchOrders(){
+    Trades trades;
+    MatchOrders(trades);
+    return trades;
+}
+
+template <typename Listener>
+void BasicOrderbook<Listener>::MatchOrders(Trades& trades){
+    OME_PROBE(EnginePhase::MatchLoop);
+
+    while(!bids_.Empty() && !asks_.Empty())
+    {
+        Price bidPrice = bids_.BestPrice();
+        Price askPrice = asks_.BestPrice();
+        auto& bids = bids_.BestLevel();
+        auto& asks = asks_.BestLevel();
+
+        if(bidPrice < askPrice)
+            break;
+
+        while(!bids.Empty() && !asks.Empty())
+        {
+            OrderHandle bidHandle = bids.Front();
+            OrderHandle askHandle = asks.Front();
+            Order& bid = pool_.Get(bidHandle);
+            Order& ask = pool_.Get(askHandle);
+
+            Quantity quantity = std::min(bid.GetRemainingQuantity(), ask.GetRemainingQuantity());
+            bid.Fill(quantity);
+            ask.Fill(quantity);
+            bids.OnFill(quantity);
+            asks.OnFill(quantity);
+
+            Price tradePrice = (lastAggressorSide_ == Side::Buy)
+                                ? ask.GetPrice()   // buy aggressor hits ask
+                                : bid.GetPrice();  // sell aggressor hits bid
+
+            trades.push_back(Trade{
+                            TradeInfo{bid.GetOrderId(), tradePrice, quantity},
+                            TradeInfo{ask.GetOrderId(), tradePrice, quantity}});
+
+            matchedOrders_++;
+            
+            // ---- EVENT: TRADE ----
+            if (listener_.Enabled()) 
+            {
+                Event ev;
+                ev.type = Event::EVT_TRADE;
+                ev.seq  = event_seq_++;
+                ev.order_id  = bid.GetOrderId();
+                ev.order_id2 = ask.GetOrderId();
+                ev.price = tradePrice;
+                ev.qty   = quantity;
+                ev.side  = 255; 
+                EmitEvent(ev);
+            }
+
+            if(bid.IsFilled()){
+                orders_.Extract(bid.GetOrderId());
+                bids.Erase(pool_, bidHandle);
+                pool_.Release(bidHandle);
+            }
+
+            if(ask.IsFilled()){
+                orders_.Extract(ask.GetOrderId());
+                asks.Erase(pool_, askHandle);
+                pool_.Release(askHandle);
+            }                
+        }
+        // matching only ever consumes the best levels
+        if(bids.Empty()){
+            bids_.EraseLevel(bidPrice);
+            RefreshBestBid();
+        }
+
+        if(asks.Empty()){
+            asks_.EraseLevel(askPrice);
+            RefreshBestAsk();
+        }
+    }
+
+    // Only orders admitted since the last pass can be non-GTC, so cancel
+    // their remainders directly instead of scanning the whole book
+    OME_PROBE(EnginePhase::Cleanup);
+    for (OrderId id : transientOrders_) {
+        CancelOrder(id);
+    }
+    transientOrders_.clear();
+}
+
+template <typename Listener>
+Trades BasicOrderbook<Listener>::AddOrder(OrderPointer order)
+{
+    return AddOrder(*order);
+}
+
+template <typename Listener>
+Trades BasicOrderbook<Listener>::AddOrder(const Order& order)
+{
+    Trades trades;
+    AddOrder(order, trades);
+    return trades;
+}
+
+template <typename Listener>
+void BasicOrderbook<Listener>::AddOrder(const Order& incoming, Trades& trades)
+{
+    if(AdmitOrder(incoming))
+        MatchOrders(trades);
+}
+
+template <typename Listener>
+bool BasicOrderbook<Listener>::AdmitOrder(const Order& incoming)
+{
+    {
+        OME_PROBE(EnginePhase::Index);
+        if(orders_.Contains(incoming.GetOrderId()))
+            return false;
+    }
+
+    Order order = incoming;
+
+    lastAggressorSide_ = order.GetSide();
+    bool isMarket = (order.GetOrderType() == OrderType::Market);
+
+    if (isMarket) {
+        // Most aggressive price the book can hold on the order's side
+        Price aggressive = (order.GetSide() == Side::Buy)
+            ? bids_.PriceCeiling()
+            : asks_.PriceFloor();
+
+        // Convert to IOC — ensures remainder auto-canceled in cleanup
+        order.ToImmediateOrCancel(aggressive);
+    }
+
+    if (!isMarket) {
+        OME_PROBE(EnginePhase::Admission);
+        if(order.GetOrderType() == OrderType::ImmediateOrCancel && !CanMatch(order.GetSide(), order.GetPrice()))
+            return false;
+
+        if(order.GetOrderType() == OrderType::FillOrKill && !CanFullyFill(order.GetSide(), order.GetPrice(), order.GetInitialQuantity()))
+            return false;
+    }
+
+    PriceLevel* level;
+    OrderHandle handle;
+    {
+        OME_PROBE(EnginePhase::LevelInsert);
+        level = (order.GetSide() == Side::Buy) ? &bids_.AddLevel(order.GetPrice()) : &asks_.AddLevel(order.GetPrice());
+        handle = pool_.Allocate(order);
+        level->PushBack(pool_, handle);
+    }
+
+    // a new order can only improve the touch on its own side
+    {
+        OME_PROBE(EnginePhase::BestPrice);
+        if(order.GetSide() == Side::Buy){
+            if(!bestBidLevel_ || order.GetPrice() > bestBid_){
+                bestBid_ = order.GetPrice();
+                bestBidLevel_ = level;
+            }
+        }
+        else if(!bestAskLevel_ || order.GetPrice() < bestAsk_){
+            bestAsk_ = order.GetPrice();
+            bestAskLevel_ = level;
+        }
+    }
+    {
+        OME_PROBE(EnginePhase::Index);
+        orders_.Insert(order.GetOrderId(), handle);
+    }
+
+    if (order.GetOrderType() != OrderType::GoodTillCancel)
+        transientOrders_.push_back(order.GetOrderId());
+
+    // <<<<<< EVENT: ADD
+    if (listener_.Enabled()) 
+    {
+        Event ev;
+        ev.type = Event::EVT_ADD;
+        ev.seq = event_seq_++;
+        ev.order_id = order.GetOrderId();
+        ev.order_id2 = 0;
+        ev.price = order.GetPrice();
+        ev.qty = order.GetInitialQuantity();
+        ev.side = (order.GetSide() == Side::Buy) ? 1 : 0;
+        EmitEvent(ev);
+    }
+    return true;
+}
+
+template <typename Listener>
+Trades BasicOrderbook<Listener>::MatchOrder(OrderModify order)
+{
+    Trades trades;
+    MatchOrder(order, trades);
+    return trades;
+}
+
+template <typename Listener>
+bool BasicOrderbook<Listener>::InPlaceModify(const Order& resting, const OrderModify& order)
+{
+    return order.GetSide() == resting.GetSide() && order.GetPrice() == resting.GetPrice()
+           && order.GetQuantity() > 0 && order.GetQuantity() <= resting.GetRemainingQuantity();
+}
+
+template <typename Listener>
+const Order* BasicOrderbook<Listener>::FindOrder(OrderId orderId) const
+{
+    OrderHandle handle = orders_.Find(orderId);
+    return handle == InvalidOrderHandle ? nullptr : &pool_.Get(handle);
+}
+
+template <typename Listener>
+bool BasicOrderbook<Listener>::ModifiesInPlace(const OrderModify& order) const
+{
+    const Order* resting = FindOrder(order.GetOrderId());
+    return resting && InPlaceModify(*resting, order);
+}
+
+template <typename Listener>
+void BasicOrderbook<Listener>::MatchOrder(OrderModify order, Trades& trades)
+{
+    OrderHandle handle;
+    {
+        OME_PROBE(EnginePhase::Index);
+        handle = orders_.Find(order.GetOrderId());
+    }
+    if(handle == InvalidOrderHandle)
+        return;
+
+    Order& resting = pool_.Get(handle);
+    OrderType type = resting.GetOrderType();
+    // Shrinking in place keeps time priority (a smaller resting order cannot
+    // create a cross)
+    bool inPlace = InPlaceModify(resting, order);
+
+    // A reprice outside the ladder band is rejected before the cancel, so the
+    // resting order and the event stream are left untouched
+    if(!inPlace){
+        bool inBand = (order.GetSide() == Side::Buy) ? bids_.InBand(order.GetPrice()) : asks_.InBand(order.GetPrice());
+        if(!inBand){
+            std::ostringstream oss;
+            oss << "Modify of order " << order.GetOrderId() << " to price " << order.GetPrice()
+                << " outside ladder band [" << bids_.PriceFloor() << ", " << bids_.PriceCeiling() << "]";
+            throw std::logic_error(oss.str());
+        }
+    }
+
+    // Emit MODIFY event before we cancel/reinsert so logs show the modification intent
+    if (listener_.Enabled()) 
+    {
+        Event ev;
+        ev.type = Event::EVT_MODIFY;
+        ev.seq = event_seq_++;
+        ev.order_id = order.GetOrderId();
+        ev.order_id2 = 0;
+        ev.price = order.GetPrice();
+        ev.qty = order.GetQuantity();
+        ev.side = (order.GetSide() == Side::Buy) ? 1 : 0;
+        EmitEvent(ev);
+    }
+
+    if(inPlace){
+        Quantity reduction = resting.GetRemainingQuantity() - order.GetQuantity();
+        resting.ReduceTo(order.GetQuantity());
+        pool_.Node(handle).level_->OnFill(reduction);
+        return;
+    }
+
+    CancelOrder(order.GetOrderId());
+    AddOrder(order.ToOrder(type), trades);
+}
+
+// Commands this far ahead get their index slot prefetched; half as far
+// ahead their (by then cached) slot is probed and the order node prefetched
+inline constexpr std::size_t BatchPrefetchDistance = 16;
+
+template <typename Listener>
+void BasicOrderbook<Listener>::ProcessBatch(std::span<const Command> commands, Trades& trades)
+{
+    constexpr std::size_t probeAhead = BatchPrefetchDistance / 2;
+    for(std::size_t i = 0; i < commands.size() && i < BatchPrefetchDistance; ++i)
+        orders_.Prefetch(commands[i].orderId_);
+
+    for(std::size_t i = 0; i < commands.size(); ++i){
+        if(i + BatchPrefetchDistance < commands.size())
+            orders_.Prefetch(commands[i + BatchPrefetchDistance].orderId_);
+        if(i + probeAhead < commands.size() && commands[i + probeAhead].type_ != CommandType::Add){
+            OrderHandle ahead = orders_.Find(commands[i + probeAhead].orderId_);
+            if(ahead != InvalidOrderHandle)
+                pool_.Prefetch(ahead);
+        }
+
+        const Command& c = commands[i];
+        switch(c.type_){
+        case CommandType::Add:
+            // With nothing crossed and no IOC / FOK remainder pending, a
+            // matching pass would be a no-op
+            if(AdmitOrder(Order{ c.orderType_, c.orderId_, c.side_, c.price_, c.quantity_ })
+               && (Crossed() || !transientOrders_.empty()))
+                MatchOrders(trades);
+            break;
+        case CommandType::Cancel:
+            CancelOrder(c.orderId_);
+            break;
+        case CommandType::Modify:
+            MatchOrder(OrderModify{ c.orderId_, c.side_, c.price_, c.quantity_ }, trades);
+            break;
+        }
+    }
+}
+
+template <typename Listener>
+std::size_t BasicOrderbook<Listener>::Size() const 
+{
+    return orders_.Size();
+}
+
+template <typename Listener>
+std::size_t BasicOrderbook<Listener>::GetMatchedOrders() const{
+    return matchedOrders_;
+}
+
+template <typename Listener>
+OrderbookLevelInfos BasicOrderbook<Listener>::GetOrderInfos() const 
+{
+    LevelInfos bidInfos, askInfos;
+    bidInfos.reserve(bids_.LevelCount());
+    askInfos.reserve(asks_.LevelCount());
+
+    // Levels carry their aggregate quantity, so this is a straight copy
+    bids_.ForEachLevel([&](Price price, const PriceLevel& level){
+        bidInfos.push_back(LevelInfo{ price, level.GetQuantity(), level.GetOrderCount() });
+        return true;
+    });
+
+    asks_.ForEachLevel([&](Price price, const PriceLevel& level){
+        askInfos.push_back(LevelInfo{ price, level.GetQuantity(), level.GetOrderCount() });
+        return true;
+    });
+
+    return OrderbookLevelInfos{bidInfos, askInfos};
+}
+
+template <typename Listener>
+void BasicOrderbook<Listener>::SaveSnapshot(const std::string& path) const
+{
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if(!file){
+        std::ostringstream oss;
+        oss << "Snapshot (" << path << "): cannot open for writing";
+        throw std::runtime_error(oss.str());
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic_, "OMESNAP1", sizeof(header.magic_));
+    header.version_ = SnapshotVersion;
+    header.recordSize_ = sizeof(SnapshotRecord);
+    header.lastAggressorSide_ = static_cast<std::uint8_t>(lastAggressorSide_);
+    header.matchedOrders_ = matchedOrders_;
+    header.eventSeq_ = event_seq_;
+    bids_.ForEachLevel([&](Price, const PriceLevel& level){ header.bidOrderCount_ += level.GetOrderCount(); return true; });
+    asks_.ForEachLevel([&](Price, const PriceLevel& level){ header.askOrderCount_ += level.GetOrderCount(); return true; });
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+
+    // Records are staged in chunks so the file is written in large blocks
+    std::vector<SnapshotRecord> chunk;
+    chunk.reserve(4096);
+    auto flush = [&]{
+        ok = ok && std::fwrite(chunk.data(), sizeof(SnapshotRecord), chunk.size(), file) == chunk.size();
+        chunk.clear();
+    };
+    auto writeLevel = [&](Price, const PriceLevel& level){
+        level.ForEachOrder(pool_, [&](const Order& order){
+            chunk.push_back(SnapshotRecord{ order.GetOrderId(), order.GetPrice(), order.GetInitialQuantity(),
+                                            order.GetRemainingQuantity(), static_cast<std::uint8_t>(order.GetOrderType()),
+                                            static_cast<std::uint8_t>(order.GetSide()), {} });
+            if(chunk.size() == chunk.capacity())
+                flush();
+        });
+        return true;
+    };
+    bids_.ForEachLevel(writeLevel);
+    asks_.ForEachLevel(writeLevel);
+    flush();
+
+    ok = (std::fclose(file) == 0) && ok;
+    if(!ok){
+        std::ostringstream oss;
+        oss << "Snapshot (" << path << "): write failed";
+        throw std::runtime_error(oss.str());
+    }
+}
+
+template <typename Listener>
+void BasicOrderbook<Listener>::LoadSnapshot(const std::string& path)
+{
+    auto fail = [&path](const char* what){
+        std::ostringstream oss;
+        oss << "Snapshot (" << path << "): " << what;
+        throw std::runtime_error(oss.str());
+    };
+    if(Size() != 0)
+        throw std::logic_error("LoadSnapshot requires an empty order book");
+
+    std::unique_ptr<std::FILE, int(*)(std::FILE*)> file{ std::fopen(path.c_str(), "rb"), &std::fclose };
+    if(!file)
+        fail("cannot open");
+
+    SnapshotHeader header{};
+    if(std::fread(&header, sizeof(header), 1, file.get()) != 1 || std::memcmp(header.magic_, "OMESNAP1", sizeof(header.magic_)) != 0)
+        fail("not an order-book snapshot");
+    if(header.version_ != SnapshotVersion || header.recordSize_ != sizeof(SnapshotRecord))
+        fail("unsupported snapshot version");
+
+    // Records arrive best level first and in time priority within a level,
+    // so appending each to its level's tail rebuilds the FIFOs as saved
+    std::vector<SnapshotRecord> chunk(4096);
+    std::uint64_t remaining = header.bidOrderCount_ + header.askOrderCount_;
+    while(remaining){
+        std::size_t want = static_cast<std::size_t>(std::min<std::uint64_t>(remaining, chunk.size()));
+        if(std::fread(chunk.data(), sizeof(SnapshotRecord), want, file.get()) != want)
+            fail("truncated snapshot");
+        remaining -= want;
+
+        for(std::size_t i = 0; i < want; ++i){
+            const SnapshotRecord& r = chunk[i];
+            Order order{ static_cast<OrderType>(r.orderType_), r.orderId_, static_cast<Side>(r.side_), r.price_, r.initialQuantity_ };
+            // Zero is valid: a cancel/replace to quantity 0 rests an empty order
+            if(r.remainingQuantity_ > r.initialQuantity_)
+                fail("invalid order quantity");
+            order.Fill(r.initialQuantity_ - r.remainingQuantity_);
+
+            OrderHandle handle = pool_.Allocate(order);
+            if(!orders_.Insert(order.GetOrderId(), handle))
+                fail("duplicate order id");
+            auto& level = (order.GetSide() == Side::Buy) ? bids_.AddLevel(order.GetPrice()) : asks_.AddLevel(order.GetPrice());
+            level.PushBack(pool_, handle);
+        }
+    }
+
+    matchedOrders_ = static_cast<size_t>(header.matchedOrders_);
+    event_seq_ = header.eventSeq_;
+    lastAggressorSide_ = static_cast<Side>(header.lastAggressorSide_);
+    UpdateBestPrices();
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Usings.h"
+#include <cstddef>
+
+// Storage used for each side of the book
+enum class BookLayout{
+    Map,        // std::map keyed by price (unbounded prices)
+    Ladder      // flat array indexed by tick offset within [minPrice_, maxPrice_]
+};
+
+struct OrderbookConfig{
+    BookLayout layout_{ BookLayout::Map };
+
+    // Inclusive price band covered by the ladder layout (ignored for Map)
+    Price minPrice_{ 1 };
+    Price maxPrice_{ 1000 };
+
+    // Resting orders preallocated in the order pool and id index; both grow
+    // past this if needed
+    std::size_t orderCapacity_{ 1024 };
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Usings.h"
+#include <cstdint>
+
+// Full-state order-book snapshot written by BasicOrderbook::SaveSnapshot:
+// a 64-byte header followed by one 24-byte record per resting order. Bids
+// come first (best to worst price), then asks (best to worst); within a
+// price, records are in time priority, so restoring them in file order
+// rebuilds every FIFO exactly. Integers are stored in host byte order.
+
+struct SnapshotHeader{
+    char magic_[8];                 // "OMESNAP1"
+    std::uint16_t version_;
+    std::uint16_t recordSize_;
+    std::uint8_t lastAggressorSide_;
+    std::uint8_t reserved0_[3];
+    std::uint64_t matchedOrders_;
+    std::uint64_t eventSeq_;
+    std::uint64_t bidOrderCount_;
+    std::uint64_t askOrderCount_;
+    std::uint64_t reserved1_[2];
+};
+static_assert(sizeof(SnapshotHeader) == 64, "snapshot header is fixed-width");
+
+struct SnapshotRecord{
+    OrderId orderId_;
+    Price price_;
+    Quantity initialQuantity_;
+    Quantity remainingQuantity_;
+    std::uint8_t orderType_;
+    std::uint8_t side_;
+    std::uint8_t reserved_[2];
+};
+static_assert(sizeof(SnapshotRecord) == 24, "snapshot records are fixed-width");
+
+constexpr std::uint16_t SnapshotVersion = 1;
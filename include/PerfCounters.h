@@ -0,0 +1,169 @@
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__)
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+  #define OME_PERF_EVENTS 1
+#else
+  #define OME_PERF_EVENTS 0
+#endif
+
+// Hardware event counters for the calling thread (user space only), opened
+// through perf_event_open as one group so they count over the same
+// intervals. Counters that cannot be opened (no PMU in a VM, not Linux,
+// perf_event_paranoid too strict) are left out and reported unavailable;
+// the harness then prints timings only.
+//
+// Start() / Stop() are ioctl syscalls: bracket batches of operations, not
+// single ones. Read() returns running totals scaled for multiplexing.
+
+enum class PerfEvent : std::uint8_t{
+    L1dMiss,        // L1 data cache read misses
+    LlcMiss,        // last-level cache misses
+    BranchMiss,     // mispredicted branches
+    Count
+};
+
+constexpr std::size_t PerfEventCount = static_cast<std::size_t>(PerfEvent::Count);
+
+constexpr const char* PerfEventName(PerfEvent event){
+    switch(event){
+    case PerfEvent::L1dMiss:    return "l1d_miss";
+    case PerfEvent::LlcMiss:    return "llc_miss";
+    case PerfEvent::BranchMiss: return "branch_miss";
+    default:                    return "?";
+    }
+}
+
+struct PerfSample{
+    std::array<std::uint64_t, PerfEventCount> counts_{};
+
+    std::uint64_t operator[](PerfEvent event) const { return counts_[static_cast<std::size_t>(event)]; }
+    PerfSample operator-(const PerfSample& other) const {
+        PerfSample d;
+        for(std::size_t i = 0; i < PerfEventCount; ++i)
+            d.counts_[i] = counts_[i] - other.counts_[i];
+        return d;
+    }
+};
+
+class PerfCounters{
+private:
+    std::array<int, PerfEventCount> fds_{ -1, -1, -1 };
+    int leader_{ -1 };
+    std::string status_;
+
+#if OME_PERF_EVENTS
+    static perf_event_attr Attr(PerfEvent event){
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        switch(event){
+        case PerfEvent::L1dMiss:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PerfEvent::LlcMiss:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        default:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        }
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return attr;
+    }
+#endif
+
+public:
+    PerfCounters(){
+#if OME_PERF_EVENTS
+        int firstError = 0;
+        for(std::size_t i = 0; i < PerfEventCount; ++i){
+            perf_event_attr attr = Attr(static_cast<PerfEvent>(i));
+            attr.disabled = leader_ < 0 ? 1 : 0;    // the group follows its leader
+            long fd = syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0);
+            if(fd < 0){
+                if(!firstError)
+                    firstError = errno;
+                continue;
+            }
+            fds_[i] = static_cast<int>(fd);
+            if(leader_ < 0)
+                leader_ = fds_[i];
+        }
+        if(leader_ < 0){
+            status_ = std::string{ "unavailable (perf_event_open: " } + std::strerror(firstError) + ")";
+            return;
+        }
+        for(std::size_t i = 0; i < PerfEventCount; ++i){
+            if(fds_[i] < 0)
+                continue;
+            if(!status_.empty())
+                status_ += ' ';
+            status_ += PerfEventName(static_cast<PerfEvent>(i));
+        }
+        ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+#else
+        status_ = "unavailable (perf_event_open needs Linux)";
+#endif
+    }
+
+    ~PerfCounters(){
+#if OME_PERF_EVENTS
+        for(int fd : fds_)
+            if(fd >= 0)
+                close(fd);
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool Available() const { return leader_ >= 0; }
+    bool Available(PerfEvent event) const { return fds_[static_cast<std::size_t>(event)] >= 0; }
+    // Opened events, or why none could be
+    const std::string& Status() const { return status_; }
+
+    void Start(){
+#if OME_PERF_EVENTS
+        if(leader_ >= 0)
+            ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    void Stop(){
+#if OME_PERF_EVENTS
+        if(leader_ >= 0)
+            ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    // Totals since construction (0 for unavailable events)
+    PerfSample Read() const {
+        PerfSample sample;
+#if OME_PERF_EVENTS
+        for(std::size_t i = 0; i < PerfEventCount; ++i){
+            std::uint64_t values[3]{};  // value, time enabled, time running
+            if(fds_[i] < 0 || ::read(fds_[i], values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)))
+                continue;
+            sample.counts_[i] = values[2] && values[2] < values[1]
+                ? static_cast<std::uint64_t>(static_cast<double>(values[0]) * values[1] / values[2])
+                : values[0];
+        }
+#endif
+        return sample;
+    }
+};
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Usings.h"
+#include "Side.h"
+#include "PriceLevel.h"
+#include <bit>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+// One side of the book stored as a contiguous array of price levels indexed
+// by tick offset from minPrice. A bitmap of non-empty levels lets the best
+// price cursor skip to the next populated level a word (64 ticks) at a time.
+template <Side S>
+class PriceLadder{
+private:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    Price minPrice_{ 0 };
+    Price maxPrice_{ -1 };
+    std::vector<PriceLevel> levels_;
+    std::vector<std::uint64_t> occupied_;
+    std::size_t levelCount_{ 0 };
+    std::size_t best_{ npos };
+
+    std::size_t ToIndex(Price price) const { return static_cast<std::size_t>(price - minPrice_); }
+    Price ToPrice(std::size_t index) const { return minPrice_ + static_cast<Price>(index); }
+
+    bool IsBetter(std::size_t a, std::size_t b) const {
+        return (S == Side::Buy) ? a > b : a < b;
+    }
+
+    // Highest occupied index strictly below index, or npos
+    std::size_t FindBelow(std::size_t index) const {
+        if(index == 0)
+            return npos;
+        std::size_t i = index - 1;
+        std::size_t w = i >> 6;
+        std::uint64_t word = occupied_[w] & (~0ULL >> (63 - (i & 63)));
+        while(true){
+            if(word)
+                return (w << 6) + 63 - std::countl_zero(word);
+            if(w == 0)
+                return npos;
+            word = occupied_[--w];
+        }
+    }
+
+    // Lowest occupied index strictly above index, or npos
+    std::size_t FindAbove(std::size_t index) const {
+        std::size_t i = index + 1;
+        if(i >= levels_.size())
+            return npos;
+        std::size_t w = i >> 6;
+        std::uint64_t word = occupied_[w] & (~0ULL << (i & 63));
+        while(true){
+            if(word)
+                return (w << 6) + std::countr_zero(word);
+            if(++w == occupied_.size())
+                return npos;
+            word = occupied_[w];
+        }
+    }
+
+    // Next level in priority order after index (lower for bids, higher for asks)
+    std::size_t FindNext(std::size_t index) const {
+        return (S == Side::Buy) ? FindBelow(index) : FindAbove(index);
+    }
+
+public:
+    PriceLadder() = default;
+    PriceLadder(Price minPrice, Price maxPrice){
+        if(minPrice <= 0 || maxPrice < minPrice){
+            std::ostringstream oss;
+            oss << "Invalid price ladder band [" << minPrice << ", " << maxPrice << "]";
+            throw std::logic_error(oss.str());
+        }
+        minPrice_ = minPrice;
+        maxPrice_ = maxPrice;
+        std::size_t ticks = ToIndex(maxPrice) + 1;
+        levels_.resize(ticks);
+        occupied_.assign((ticks + 63) / 64, 0);
+    }
+
+    Price GetMinPrice() const { return minPrice_; }
+    Price GetMaxPrice() const { return maxPrice_; }
+    bool InBand(Price price) const { return price >= minPrice_ && price <= maxPrice_; }
+
+    bool Empty() const { return levelCount_ == 0; }
+    std::size_t LevelCount() const { return levelCount_; }
+
+    Price BestPrice() const { return ToPrice(best_); }
+    PriceLevel& BestLevel() { return levels_[best_]; }
+    const PriceLevel& BestLevel() const { return levels_[best_]; }
+
+    // Existing level at price (caller guarantees it is populated)
+    PriceLevel& Level(Price price) { return levels_[ToIndex(price)]; }
+
+    PriceLevel& AddLevel(Price price){
+        if(!InBand(price)){
+            std::ostringstream oss;
+            oss << "Price " << price << " outside ladder band [" << minPrice_ << ", " << maxPrice_ << "]";
+            throw std::logic_error(oss.str());
+        }
+        std::size_t index = ToIndex(price);
+        std::uint64_t bit = 1ULL << (index & 63);
+        std::uint64_t& word = occupied_[index >> 6];
+        if(!(word & bit)){
+            word |= bit;
+            if(levelCount_++ == 0 || IsBetter(index, best_))
+                best_ = index;
+        }
+        return levels_[index];
+    }
+
+    void EraseLevel(Price price){
+        std::size_t index = ToIndex(price);
+        std::uint64_t bit = 1ULL << (index & 63);
+        std::uint64_t& word = occupied_[index >> 6];
+        if(!(word & bit))
+            return;
+        word &= ~bit;
+        levels_[index].Clear();
+        if(--levelCount_ == 0)
+            best_ = npos;
+        else if(index == best_)
+            best_ = FindNext(index);
+    }
+
+    // Visits populated levels best-first; fn(price, orders) returns false to stop
+    template <typename Fn>
+    void ForEachLevel(Fn&& fn) const {
+        for(std::size_t i = best_; levelCount_ != 0 && i != npos; i = FindNext(i)){
+            if(!fn(ToPrice(i), levels_[i]))
+                return;
+        }
+    }
+};
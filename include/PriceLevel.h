@@ -0,0 +1,59 @@
+#pragma once
+
+#include "OrderPool.h"
+#include <cstdint>
+
+// FIFO of resting orders at one price, linked intrusively through the
+// OrderPool slots (time priority = list order). The level's total remaining
+// quantity and order count are kept up to date on add / fill / remove.
+struct PriceLevel{
+    OrderHandle head_{ InvalidOrderHandle };
+    OrderHandle tail_{ InvalidOrderHandle };
+    Quantity quantity_{ 0 };
+    std::uint32_t count_{ 0 };
+
+    bool Empty() const { return head_ == InvalidOrderHandle; }
+    OrderHandle Front() const { return head_; }
+    Quantity GetQuantity() const { return quantity_; }
+    std::uint32_t GetOrderCount() const { return count_; }
+
+    // Call after filling (or reducing in place) an order resting at this level
+    void OnFill(Quantity quantity) { quantity_ -= quantity; }
+
+    void PushBack(OrderPool& pool, OrderHandle handle){
+        OrderNode& node = pool.Node(handle);
+        node.prev_ = tail_;
+        node.next_ = InvalidOrderHandle;
+        node.level_ = this;
+        quantity_ += node.order_.GetRemainingQuantity();
+        ++count_;
+        if(tail_ != InvalidOrderHandle)
+            pool.Node(tail_).next_ = handle;
+        else
+            head_ = handle;
+        tail_ = handle;
+    }
+
+    void Erase(OrderPool& pool, OrderHandle handle){
+        OrderNode& node = pool.Node(handle);
+        quantity_ -= node.order_.GetRemainingQuantity();
+        --count_;
+        if(node.prev_ != InvalidOrderHandle)
+            pool.Node(node.prev_).next_ = node.next_;
+        else
+            head_ = node.next_;
+        if(node.next_ != InvalidOrderHandle)
+            pool.Node(node.next_).prev_ = node.prev_;
+        else
+            tail_ = node.prev_;
+    }
+
+    void Clear() { *this = PriceLevel{}; }
+
+    // Visits orders in time priority
+    template <typename Fn>
+    void ForEachOrder(const OrderPool& pool, Fn&& fn) const {
+        for(OrderHandle h = head_; h != InvalidOrderHandle; h = pool.Node(h).next_)
+            fn(pool.Get(h));
+    }
+};
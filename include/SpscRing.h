@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+  #include <immintrin.h>
+  inline void CpuRelax() { _mm_pause(); }
+#else
+  inline void CpuRelax() { std::this_thread::yield(); }
+#endif
+
+// Busy-wait step for ring pollers: pause for a while, then start yielding
+// so a spinning thread cannot starve its peer when both share a core
+inline void SpinWait(std::uint32_t& spins){
+    if(++spins < 256)
+        CpuRelax();
+    else
+        std::this_thread::yield();
+}
+
+// Bounded single-producer / single-consumer ring. One thread may call
+// TryPush, one other thread may call TryPop; neither ever blocks or locks.
+// Head and tail sit on separate cache lines, and each side keeps a cached
+// copy of the other's index so the shared line is only re-read when the
+// ring looks full (producer) or empty (consumer).
+template <typename T>
+class SpscRing{
+private:
+    static constexpr std::size_t CacheLine = 64;
+
+    std::vector<T> slots_;
+    std::size_t mask_;
+
+    // Consumer side
+    alignas(CacheLine) std::atomic<std::size_t> head_{ 0 };
+    std::size_t cachedTail_{ 0 };
+
+    // Producer side
+    alignas(CacheLine) std::atomic<std::size_t> tail_{ 0 };
+    std::size_t cachedHead_{ 0 };
+
+    // Keeps the producer line from sharing with whatever follows the ring
+    char pad_[CacheLine - sizeof(std::atomic<std::size_t>) - sizeof(std::size_t)];
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscRing(std::size_t capacity)
+        : slots_(std::bit_ceil(capacity < 2 ? std::size_t{ 2 } : capacity))
+        , mask_{ slots_.size() - 1 }
+    {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    bool TryPush(const T& value){
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if(tail - cachedHead_ == slots_.size()){
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if(tail - cachedHead_ == slots_.size())
+                return false;
+        }
+        slots_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& value){
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if(head == cachedTail_){
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if(head == cachedTail_)
+                return false;
+        }
+        value = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called concurrently; exact once both sides are idle
+    bool Empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+    std::size_t Capacity() const { return slots_.size(); }
+};
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+  #include <intrin.h>
+  #define OME_TSC_X86 1
+#elif defined(__x86_64__) || defined(__i386__)
+  #include <cpuid.h>
+  #include <x86intrin.h>
+  #define OME_TSC_X86 1
+#else
+  #define OME_TSC_X86 0
+#endif
+
+// Calibrated timestamp source for per-op latency probes.
+//
+// Calibrate() checks for an invariant TSC (constant rate across P-states,
+// not stopped in deep C-states: CPUID 0x80000007 EDX bit 8) and measures its
+// rate against steady_clock over a few short windows. If the TSC is missing,
+// not invariant, or the windows disagree, the clock stays on steady_clock.
+// Until Calibrate() is called every read is steady_clock ns.
+//
+// Ticks are only meaningful as differences on one clock; convert them with
+// ToNs(). Now() is a plain read for back-to-back stamps; Start() / Stop()
+// fence the read so the timed code cannot drift outside the interval.
+
+enum class ClockSource : std::uint8_t{
+    Tsc,
+    Steady
+};
+
+constexpr const char* ClockSourceName(ClockSource source){
+    return source == ClockSource::Tsc ? "tsc" : "steady_clock";
+}
+
+struct ClockCalibration{
+    ClockSource source_{ ClockSource::Steady };
+    bool invariantTsc_{ false };
+    double ticksPerNs_{ 1.0 };      // TSC GHz; 1 on steady_clock
+    double spreadPct_{ 0.0 };       // max - min rate across windows, % of the median
+};
+
+class TscClock{
+private:
+    using Steady = std::chrono::steady_clock;
+
+    static constexpr int CalibrationRounds = 5;
+    static constexpr double MaxSpreadPct = 0.5;
+
+    static inline ClockSource source_{ ClockSource::Steady };
+    static inline double nsPerTick_{ 1.0 };
+    static inline ClockCalibration calibration_{};
+
+    static std::uint64_t SteadyNs(){
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Steady::now().time_since_epoch()).count());
+    }
+
+#if OME_TSC_X86
+    static double MeasureTicksPerNs(std::chrono::nanoseconds window){
+        std::uint64_t t0 = SteadyNs();
+        std::uint64_t c0 = __rdtsc();
+        std::uint64_t t1 = t0;
+        while(t1 - t0 < static_cast<std::uint64_t>(window.count()))
+            t1 = SteadyNs();
+        std::uint64_t c1 = __rdtsc();
+        return static_cast<double>(c1 - c0) / static_cast<double>(t1 - t0);
+    }
+#endif
+
+public:
+    static bool InvariantTsc(){
+#if defined(_MSC_VER)
+        int regs[4]{};
+        __cpuid(regs, 0x80000000);
+        if(static_cast<unsigned>(regs[0]) < 0x80000007u)
+            return false;
+        __cpuid(regs, 0x80000007);
+        return (regs[3] >> 8) & 1;
+#elif OME_TSC_X86
+        unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if(__get_cpuid_max(0x80000000u, nullptr) < 0x80000007u)
+            return false;
+        __get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx);
+        return (edx >> 8) & 1;
+#else
+        return false;
+#endif
+    }
+
+    // Selects the clock for the process. allowTsc = false forces steady_clock.
+    // Takes about `window` of wall time when the TSC is a candidate.
+    static const ClockCalibration& Calibrate(std::chrono::milliseconds window = std::chrono::milliseconds{ 50 },
+                                             bool allowTsc = true){
+        ClockCalibration c;
+        c.invariantTsc_ = InvariantTsc();
+#if OME_TSC_X86
+        if(allowTsc && c.invariantTsc_){
+            std::array<double, CalibrationRounds> rates{};
+            for(double& rate : rates)
+                rate = MeasureTicksPerNs(window / CalibrationRounds);
+            std::sort(rates.begin(), rates.end());
+            double median = rates[CalibrationRounds / 2];
+            c.spreadPct_ = median > 0 ? 100.0 * (rates.back() - rates.front()) / median : 100.0;
+            if(median > 0 && c.spreadPct_ <= MaxSpreadPct){
+                c.source_ = ClockSource::Tsc;
+                c.ticksPerNs_ = median;
+            }
+        }
+#else
+        (void)window;
+        (void)allowTsc;
+#endif
+        calibration_ = c;
+        source_ = c.source_;
+        nsPerTick_ = 1.0 / c.ticksPerNs_;
+        return calibration_;
+    }
+
+    static const ClockCalibration& Calibration() { return calibration_; }
+    static ClockSource Source() { return source_; }
+
+    static std::uint64_t Now(){
+#if OME_TSC_X86
+        if(source_ == ClockSource::Tsc)
+            return __rdtsc();
+#endif
+        return SteadyNs();
+    }
+
+    // Opens an interval: earlier instructions retire before the read, later
+    // ones do not start until it is taken
+    static std::uint64_t Start(){
+#if OME_TSC_X86
+        if(source_ == ClockSource::Tsc){
+            _mm_lfence();
+            std::uint64_t t = __rdtsc();
+            _mm_lfence();
+            return t;
+        }
+#endif
+        return SteadyNs();
+    }
+
+    // Closes an interval: rdtscp waits for the timed code to retire, the
+    // fence keeps the code after it from being hoisted above the read
+    static std::uint64_t Stop(){
+#if OME_TSC_X86
+        if(source_ == ClockSource::Tsc){
+            unsigned aux;
+            std::uint64_t t = __rdtscp(&aux);
+            _mm_lfence();
+            return t;
+        }
+#endif
+        return SteadyNs();
+    }
+
+    static std::uint64_t ToNs(std::uint64_t ticks){
+        return source_ == ClockSource::Tsc
+            ? static_cast<std::uint64_t>(static_cast<double>(ticks) * nsPerTick_ + 0.5)
+            : ticks;
+    }
+};
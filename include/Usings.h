@@ -4,4 +4,5 @@
 
 using Price = std::int32_t;
 using Quantity = std::uint32_t;
-using OrderId = std::uint64_t;
\ No newline at end of file
+using OrderId = std::uint64_t;
+using SymbolId = std::uint32_t;
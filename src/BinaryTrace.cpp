@@ -0,0 +1,271 @@
+#include "BinaryTrace.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char TraceMagic[8] = { 'O', 'M', 'E', 'T', 'R', 'A', 'C', 'E' };
+constexpr std::size_t WriterBufferRecords = 4096;
+
+[[noreturn]] void ThrowTraceError(const std::string& what, const std::string& path){
+    std::ostringstream oss;
+    oss << "Trace (" << path << "): " << what;
+    throw std::runtime_error(oss.str());
+}
+
+}
+
+// ---------- writer ----------
+
+BinaryTraceWriter::~BinaryTraceWriter(){
+    try { Close(); } catch (...) {}
+}
+
+void BinaryTraceWriter::Open(const std::string& path, std::uint64_t seed, const std::string& scenario){
+    Close();
+    file_ = std::fopen(path.c_str(), "wb");
+    if(!file_)
+        ThrowTraceError("cannot open for writing", path);
+
+    TraceHeader header{};
+    std::memcpy(header.magic_, TraceMagic, sizeof(TraceMagic));
+    header.version_ = TraceVersion;
+    header.recordSize_ = sizeof(TraceRecord);
+    header.seed_ = seed;
+    std::memcpy(header.scenario_, scenario.data(), std::min(scenario.size(), sizeof(header.scenario_) - 1));
+    if(std::fwrite(&header, sizeof(header), 1, file_) != 1)
+        ThrowTraceError("header write failed", path);
+
+    buffer_.clear();
+    buffer_.reserve(WriterBufferRecords);
+    count_ = 0;
+}
+
+void BinaryTraceWriter::Flush(){
+    if(buffer_.empty())
+        return;
+    if(std::fwrite(buffer_.data(), sizeof(TraceRecord), buffer_.size(), file_) != buffer_.size())
+        throw std::runtime_error("Trace: record write failed");
+    count_ += buffer_.size();
+    buffer_.clear();
+}
+
+void BinaryTraceWriter::Close(){
+    if(!file_)
+        return;
+    bool ok = true;
+    try { Flush(); } catch (...) { ok = false; }
+    // Patch the record count now that it is known
+    ok = ok && std::fseek(file_, offsetof(TraceHeader, recordCount_), SEEK_SET) == 0
+            && std::fwrite(&count_, sizeof(count_), 1, file_) == 1;
+    ok = (std::fclose(file_) == 0) && ok;
+    file_ = nullptr;
+    if(!ok)
+        throw std::runtime_error("Trace: finalising trace file failed");
+}
+
+// ---------- memory-mapped reader ----------
+
+MappedTrace::MappedTrace(const std::string& path){
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+        ThrowTraceError("cannot open", path);
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size)){
+        CloseHandle(file);
+        ThrowTraceError("cannot stat", path);
+    }
+    size_ = static_cast<std::size_t>(size.QuadPart);
+    HANDLE mapping = size_ ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if(!view){
+        if(mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        ThrowTraceError("cannot map", path);
+    }
+    file_ = file;
+    mapping_ = mapping;
+    data_ = static_cast<const unsigned char*>(view);
+#else
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if(fd_ < 0)
+        ThrowTraceError("cannot open", path);
+    struct stat st;
+    if(::fstat(fd_, &st) != 0){
+        ::close(fd_);
+        ThrowTraceError("cannot stat", path);
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    void* view = size_ ? ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0) : MAP_FAILED;
+    if(view == MAP_FAILED){
+        ::close(fd_);
+        ThrowTraceError("cannot map", path);
+    }
+    // Replay reads front to back
+    (void)::madvise(view, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const unsigned char*>(view);
+#endif
+
+    std::string error;
+    if(size_ < sizeof(TraceHeader) || std::memcmp(Header().magic_, TraceMagic, sizeof(TraceMagic)) != 0)
+        error = "not a binary trace";
+    else if(Header().version_ != TraceVersion || Header().recordSize_ != sizeof(TraceRecord))
+        error = "unsupported trace version";
+    else if(size_ < sizeof(TraceHeader) + Header().recordCount_ * sizeof(TraceRecord))
+        error = "truncated trace";
+    if(!error.empty()){
+        Unmap();
+        ThrowTraceError(error, path);
+    }
+}
+
+MappedTrace::~MappedTrace(){
+    Unmap();
+}
+
+void MappedTrace::Unmap(){
+    if(!data_)
+        return;
+#if defined(_WIN32)
+    UnmapViewOfFile(data_);
+    CloseHandle(static_cast<HANDLE>(mapping_));
+    CloseHandle(static_cast<HANDLE>(file_));
+#else
+    ::munmap(const_cast<unsigned char*>(data_), size_);
+    ::close(fd_);
+#endif
+    data_ = nullptr;
+}
+
+// ---------- CSV <-> binary ----------
+
+std::uint64_t ConvertTraceCsvToBinary(const std::string& csvPath, const std::string& binPath){
+    std::ifstream in(csvPath);
+    if(!in)
+        ThrowTraceError("cannot open", csvPath);
+
+    // Header comment: "# seed=<n>,scenario=<name>"
+    std::uint64_t seed = 0;
+    std::string scenario;
+    std::string line;
+    if(in.peek() == '#' && std::getline(in, line)){
+        auto seedPos = line.find("seed=");
+        auto scenarioPos = line.find("scenario=");
+        if(seedPos != std::string::npos)
+            seed = std::stoull(line.substr(seedPos + 5));
+        if(scenarioPos != std::string::npos)
+            scenario = line.substr(scenarioPos + 9);
+    }
+
+    BinaryTraceWriter writer;
+    writer.Open(binPath, seed, scenario);
+    std::uint64_t count = 0;
+    std::uint64_t lineno = 1;
+    while(std::getline(in, line)){
+        ++lineno;
+        if(line.empty() || line[0] == '#')
+            continue;
+        std::istringstream iss(line);
+        std::string op, token;
+        std::getline(iss, op, ',');
+        // Every field is range-checked: a value the record cannot hold would
+        // otherwise convert silently into a different trace
+        auto next = [&](long long lo, long long hi, const char* field){
+            std::size_t used = 0;
+            long long value = 0;
+            bool ok = static_cast<bool>(std::getline(iss, token, ','));
+            try {
+                if(ok)
+                    value = std::stoll(token, &used);
+            } catch (const std::exception&) {
+                ok = false;
+            }
+            if(!ok || used != token.size() || value < lo || value > hi){
+                std::ostringstream oss;
+                oss << "malformed line " << lineno;
+                if(ok)
+                    oss << ": " << field << " " << token << " out of range";
+                ThrowTraceError(oss.str(), csvPath);
+            }
+            return value;
+        };
+        constexpr long long MaxId = std::numeric_limits<std::uint32_t>::max();
+        constexpr long long MaxType = static_cast<long long>(OrderType::Market);
+        constexpr long long MaxSide = static_cast<long long>(Side::Sell);
+        constexpr long long MinPrice = std::numeric_limits<Price>::min();
+        constexpr long long MaxPrice = std::numeric_limits<Price>::max();
+        constexpr long long MaxQuantity = std::numeric_limits<Quantity>::max();
+        if(op == "ADD"){
+            auto id = next(0, MaxId, "order id");
+            auto type = next(0, MaxType, "order type");
+            auto side = next(0, MaxSide, "side");
+            auto price = next(MinPrice, MaxPrice, "price");
+            auto qty = next(0, MaxQuantity, "quantity");
+            writer.WriteAdd(static_cast<std::uint32_t>(id), static_cast<OrderType>(type), static_cast<Side>(side),
+                            static_cast<Price>(price), static_cast<Quantity>(qty));
+        } else if(op == "CANCEL"){
+            writer.WriteCancel(static_cast<std::uint32_t>(next(0, MaxId, "order id")));
+        } else if(op == "MATCH"){
+            writer.WriteMatch();
+        } else if(op == "MODIFY"){
+            auto id = next(0, MaxId, "order id");
+            auto side = next(0, MaxSide, "side");
+            auto price = next(MinPrice, MaxPrice, "price");
+            auto qty = next(0, MaxQuantity, "quantity");
+            writer.WriteModify(static_cast<std::uint32_t>(id), static_cast<Side>(side),
+                               static_cast<Price>(price), static_cast<Quantity>(qty));
+        } else {
+            std::ostringstream oss;
+            oss << "unknown op '" << op << "' at line " << lineno;
+            ThrowTraceError(oss.str(), csvPath);
+        }
+        ++count;
+    }
+    writer.Close();
+    return count;
+}
+
+std::uint64_t ConvertTraceBinaryToCsv(const std::string& binPath, const std::string& csvPath){
+    MappedTrace trace(binPath);
+    std::ofstream out(csvPath);
+    if(!out)
+        ThrowTraceError("cannot open for writing", csvPath);
+
+    const TraceHeader& header = trace.Header();
+    out << "# seed=" << header.seed_ << ",scenario="
+        << std::string(header.scenario_, strnlen(header.scenario_, sizeof(header.scenario_))) << "\n";
+    for(const TraceRecord& r : trace.Records()){
+        switch(r.op_){
+        case TraceOp::Add:
+            out << "ADD," << r.orderId_ << "," << +r.orderType_ << "," << +r.side_ << "," << r.price_ << "," << r.quantity_ << "\n";
+            break;
+        case TraceOp::Cancel:
+            out << "CANCEL," << r.orderId_ << "\n";
+            break;
+        case TraceOp::Match:
+            out << "MATCH\n";
+            break;
+        case TraceOp::Modify:
+            out << "MODIFY," << r.orderId_ << "," << +r.side_ << "," << r.price_ << "," << r.quantity_ << "\n";
+            break;
+        }
+    }
+    if(!out)
+        ThrowTraceError("write failed", csvPath);
+    return trace.Records().size();
+}
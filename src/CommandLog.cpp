@@ -0,0 +1,221 @@
+#include "CommandLog.h"
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__SSE4_2__)
+  #include <nmmintrin.h>
+#endif
+
+#if defined(_WIN32)
+  #include <io.h>
+#else
+  #include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char CommandLogMagic[8] = { 'O', 'M', 'E', 'C', 'M', 'D', 'L', 'G' };
+constexpr std::size_t ReaderChunkRecords = 4096;
+
+[[noreturn]] void ThrowLogError(const std::string& what, const std::string& path){
+    std::ostringstream oss;
+    oss << "Command log (" << path << "): " << what;
+    throw std::runtime_error(oss.str());
+}
+
+// CRC-32C (Castagnoli); the SSE4.2 instruction and the table agree, so
+// logs verify across builds
+std::uint32_t Crc32c(const unsigned char* data, std::size_t size){
+    std::uint32_t crc = 0xFFFFFFFFu;
+    std::size_t i = 0;
+#if defined(__SSE4_2__)
+    std::uint64_t wide = crc;
+    for(; i + 8 <= size; i += 8){
+        std::uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        wide = _mm_crc32_u64(wide, word);
+    }
+    crc = static_cast<std::uint32_t>(wide);
+    for(; i < size; ++i)
+        crc = _mm_crc32_u8(crc, data[i]);
+#else
+    static const std::array<std::uint32_t, 256> table = []{
+        std::array<std::uint32_t, 256> t{};
+        for(std::uint32_t n = 0; n < 256; ++n){
+            std::uint32_t c = n;
+            for(int k = 0; k < 8; ++k)
+                c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    for(; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+#endif
+    return ~crc;
+}
+
+bool SyncFile(std::FILE* file){
+    if(std::fflush(file) != 0)
+        return false;
+#if defined(_WIN32)
+    return _commit(_fileno(file)) == 0;
+#elif defined(__APPLE__)
+    return fsync(fileno(file)) == 0;
+#else
+    return fdatasync(fileno(file)) == 0;
+#endif
+}
+
+}
+
+std::uint32_t CommandLogRecordCrc(const CommandLogRecord& record){
+    return Crc32c(reinterpret_cast<const unsigned char*>(&record), offsetof(CommandLogRecord, crc_));
+}
+
+// ---------- writer ----------
+
+CommandLog::~CommandLog(){
+    try { Close(); } catch (...) {}
+}
+
+void CommandLog::Open(const std::string& path, const CommandLogConfig& config){
+    Close();
+    file_ = std::fopen(path.c_str(), "wb");
+    if(!file_)
+        ThrowLogError("cannot open for writing", path);
+
+    config_ = config;
+    if(config_.groupCommitCount_ == 0)
+        config_.groupCommitCount_ = 1;
+    group_.clear();
+    group_.reserve(config_.groupCommitCount_);
+    nextLsn_ = 1;
+    durableLsn_ = 0;
+    commits_ = 0;
+
+    CommandLogHeader header{};
+    std::memcpy(header.magic_, CommandLogMagic, sizeof(CommandLogMagic));
+    header.version_ = CommandLogVersion;
+    header.recordSize_ = sizeof(CommandLogRecord);
+    if(std::fwrite(&header, sizeof(header), 1, file_) != 1 || !SyncFile(file_)){
+        std::fclose(file_);
+        file_ = nullptr;
+        ThrowLogError("header write failed", path);
+    }
+}
+
+void CommandLog::Close(){
+    if(!file_)
+        return;
+    std::FILE* file = file_;
+    try {
+        Commit();
+    } catch (...) {
+        std::fclose(file);
+        file_ = nullptr;
+        throw;
+    }
+    file_ = nullptr;
+    if(std::fclose(file) != 0)
+        throw std::runtime_error("Command log: close failed");
+}
+
+std::uint64_t CommandLog::Append(const Command& command, std::uint64_t eventSeq){
+    if(group_.empty())
+        groupStart_ = Clock::now();
+
+    // Commit() clears group_, so r must not be read after it
+    const std::uint64_t lsn = nextLsn_++;
+    CommandLogRecord& r = group_.emplace_back();
+    r.lsn_ = lsn;
+    r.eventSeq_ = eventSeq;
+    r.orderId_ = command.orderId_;
+    r.symbol_ = command.symbol_;
+    r.price_ = command.price_;
+    r.quantity_ = command.quantity_;
+    r.type_ = command.type_;
+    r.orderType_ = static_cast<std::uint8_t>(command.orderType_);
+    r.side_ = static_cast<std::uint8_t>(command.side_);
+    r.reserved_ = 0;
+    r.crc_ = CommandLogRecordCrc(r);
+    r.padding_ = 0;
+
+    if(group_.size() >= config_.groupCommitCount_)
+        Commit();
+    else
+        Poll();
+    return lsn;
+}
+
+void CommandLog::Poll(){
+    if(!group_.empty() && Clock::now() - groupStart_ >= config_.groupCommitInterval_)
+        Commit();
+}
+
+void CommandLog::Commit(){
+    if(group_.empty())
+        return;
+    bool ok = std::fwrite(group_.data(), sizeof(CommandLogRecord), group_.size(), file_) == group_.size();
+    ok = ok && (config_.sync_ ? SyncFile(file_) : std::fflush(file_) == 0);
+    if(!ok)
+        throw std::runtime_error("Command log: group commit failed");
+    durableLsn_ = group_.back().lsn_;
+    group_.clear();
+    ++commits_;
+}
+
+// ---------- reader ----------
+
+CommandLogReader::CommandLogReader(const std::string& path)
+    : chunk_(ReaderChunkRecords)
+{
+    file_ = std::fopen(path.c_str(), "rb");
+    if(!file_)
+        ThrowLogError("cannot open", path);
+
+    CommandLogHeader header{};
+    std::string error;
+    if(std::fread(&header, sizeof(header), 1, file_) != 1 || std::memcmp(header.magic_, CommandLogMagic, sizeof(CommandLogMagic)) != 0)
+        error = "not a command log";
+    else if(header.version_ != CommandLogVersion || header.recordSize_ != sizeof(CommandLogRecord))
+        error = "unsupported command log version";
+    if(!error.empty()){
+        std::fclose(file_);
+        file_ = nullptr;
+        ThrowLogError(error, path);
+    }
+}
+
+CommandLogReader::~CommandLogReader(){
+    if(file_)
+        std::fclose(file_);
+}
+
+bool CommandLogReader::Next(CommandLogRecord& record){
+    if(ended_)
+        return false;
+    if(pos_ == count_){
+        std::size_t bytes = std::fread(chunk_.data(), 1, chunk_.size() * sizeof(CommandLogRecord), file_);
+        count_ = bytes / sizeof(CommandLogRecord);
+        pos_ = 0;
+        // Chunks are only short at end of file: a partial record is the tail
+        if(bytes % sizeof(CommandLogRecord))
+            torn_ = true;
+        if(count_ == 0){
+            ended_ = true;
+            return false;
+        }
+    }
+    const CommandLogRecord& r = chunk_[pos_];
+    if(r.lsn_ != nextLsn_ || r.crc_ != CommandLogRecordCrc(r)){
+        torn_ = true;
+        ended_ = true;
+        return false;
+    }
+    record = r;
+    ++pos_;
+    ++nextLsn_;
+    return true;
+}
@@ -0,0 +1,160 @@
+#include "EventJournal.h"
+#include "Orderbook.inl"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+constexpr char JournalMagic[8] = { 'O', 'M', 'E', 'E', 'V', 'E', 'N', 'T' };
+
+[[noreturn]] void ThrowJournalError(const std::string& what, const std::string& path){
+    std::ostringstream oss;
+    oss << "Event journal (" << path << "): " << what;
+    throw std::runtime_error(oss.str());
+}
+
+}
+
+EventJournal::~EventJournal(){
+    try { Close(); } catch (...) {}
+}
+
+void EventJournal::Open(const std::string& path, std::size_t capacityRecords, bool backgroundFlush){
+    Close();
+    file_ = std::fopen(path.c_str(), "wb");
+    if(!file_)
+        ThrowJournalError("cannot open for writing", path);
+
+    JournalHeader header{};
+    std::memcpy(header.magic_, JournalMagic, sizeof(JournalMagic));
+    header.version_ = JournalVersion;
+    header.recordSize_ = sizeof(JournalRecord);
+    if(std::fwrite(&header, sizeof(header), 1, file_) != 1){
+        std::fclose(file_);
+        file_ = nullptr;
+        ThrowJournalError("header write failed", path);
+    }
+
+    // Zeroed up front so reserved bytes are deterministic and pages are touched
+    active_.assign(capacityRecords ? capacityRecords : 1, JournalRecord{});
+    used_ = 0;
+    appended_ = 0;
+    failed_ = false;
+
+    background_ = backgroundFlush;
+    if(background_){
+        pending_.assign(active_.size(), JournalRecord{});
+        pendingFull_ = false;
+        stop_ = false;
+        flusher_ = std::thread([this]{ FlushLoop(); });
+    }
+}
+
+void EventJournal::WriteRecords(const JournalRecord* records, std::size_t count){
+    if(count && std::fwrite(records, sizeof(JournalRecord), count, file_) != count)
+        failed_ = true;
+}
+
+void EventJournal::Rotate(){
+    if(!background_){
+        WriteRecords(active_.data(), used_);
+        used_ = 0;
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]{ return !pendingFull_; });
+        std::swap(active_, pending_);
+        pendingCount_ = used_;
+        pendingFull_ = true;
+    }
+    cv_.notify_all();
+    used_ = 0;
+}
+
+void EventJournal::FlushLoop(){
+    std::unique_lock<std::mutex> lock(mutex_);
+    for(;;){
+        cv_.wait(lock, [this]{ return pendingFull_ || stop_; });
+        if(pendingFull_){
+            std::size_t count = pendingCount_;
+            lock.unlock();
+            WriteRecords(pending_.data(), count);
+            lock.lock();
+            pendingFull_ = false;
+            cv_.notify_all();
+            continue;
+        }
+        if(stop_)
+            return;
+    }
+}
+
+void EventJournal::Close(){
+    if(!file_)
+        return;
+    if(used_)
+        Rotate();
+    if(background_){
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        flusher_.join();
+        background_ = false;
+        pending_ = {};
+    }
+    bool ok = !failed_;
+    ok = (std::fclose(file_) == 0) && ok;
+    file_ = nullptr;
+    active_ = {};
+    if(!ok)
+        throw std::runtime_error("Event journal: write failed");
+}
+
+std::uint64_t DecodeEventJournalToCsv(const std::string& journalPath, const std::string& csvPath){
+    std::ifstream in(journalPath, std::ios::binary);
+    if(!in)
+        ThrowJournalError("cannot open", journalPath);
+
+    JournalHeader header{};
+    if(!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+       || std::memcmp(header.magic_, JournalMagic, sizeof(JournalMagic)) != 0)
+        ThrowJournalError("not an event journal", journalPath);
+    if(header.version_ != JournalVersion || header.recordSize_ != sizeof(JournalRecord))
+        ThrowJournalError("unsupported journal version", journalPath);
+
+    std::ofstream out(csvPath);
+    if(!out)
+        ThrowJournalError("cannot open for writing", csvPath);
+    out << "# columns=seq,type,order_id,order_id2,price,qty,side\n";
+
+    std::vector<JournalRecord> chunk(4096);
+    std::uint64_t count = 0;
+    while(in){
+        in.read(reinterpret_cast<char*>(chunk.data()), chunk.size() * sizeof(JournalRecord));
+        std::size_t got = static_cast<std::size_t>(in.gcount()) / sizeof(JournalRecord);
+        for(std::size_t i = 0; i < got; ++i){
+            const JournalRecord& r = chunk[i];
+            Event e{};
+            e.type = static_cast<Event::Type>(r.type_);
+            e.seq = r.seq_;
+            e.order_id = r.orderId_;
+            e.order_id2 = r.orderId2_;
+            e.price = r.price_;
+            e.qty = r.quantity_;
+            e.side = r.side_;
+            out << e.to_csv() << "\n";
+        }
+        count += got;
+    }
+    if(!out)
+        ThrowJournalError("write failed", csvPath);
+    return count;
+}
+
+template class BasicOrderbook<JournalEventListener>;
@@ -0,0 +1,85 @@
+#include "MatchingEngine.h"
+#include <sstream>
+#include <stdexcept>
+
+MatchingEngine::MatchingEngine(const MatchingEngineConfig& config)
+    : config_{ config }
+{
+    if(config_.shardCount_ == 0)
+        throw std::logic_error("MatchingEngine: shardCount must be > 0");
+
+    shards_.reserve(config_.shardCount_);
+    for(std::size_t i = 0; i < config_.shardCount_; ++i){
+        MatchingThreadConfig shardConfig;
+        shardConfig.book_ = config_.book_;
+        shardConfig.inboundCapacity_ = config_.inboundCapacity_;
+        shardConfig.outboundCapacity_ = config_.outboundCapacity_;
+        shardConfig.cpu_ = config_.firstCpu_ < 0 ? -1 : config_.firstCpu_ + static_cast<int>(i);
+        shardConfig.events_ = config_.events_;
+        shards_.push_back(std::make_unique<MatchingThread>(shardConfig));
+    }
+}
+
+MatchingEngine::~MatchingEngine(){
+    Stop();
+}
+
+void MatchingEngine::AddSymbol(SymbolId symbol){
+    AddSymbol(symbol, symbolCount_ % shards_.size());
+}
+
+void MatchingEngine::AddSymbol(SymbolId symbol, std::size_t shard){
+    if(shard >= shards_.size()){
+        std::ostringstream oss;
+        oss << "MatchingEngine: shard " << shard << " out of range (" << shards_.size() << " shards)";
+        throw std::logic_error(oss.str());
+    }
+    if(symbol >= shardOf_.size())
+        shardOf_.resize(static_cast<std::size_t>(symbol) + 1, NoShard);
+    if(shardOf_[symbol] != NoShard){
+        std::ostringstream oss;
+        oss << "MatchingEngine: symbol " << symbol << " already added";
+        throw std::logic_error(oss.str());
+    }
+    shards_[shard]->AddSymbol(symbol);
+    shardOf_[symbol] = static_cast<std::uint32_t>(shard);
+    ++symbolCount_;
+}
+
+void MatchingEngine::Start(){
+    for(auto& shard : shards_)
+        shard->Start();
+}
+
+void MatchingEngine::Stop(){
+    for(auto& shard : shards_)
+        shard->Stop();
+}
+
+std::size_t MatchingEngine::ShardOf(SymbolId symbol) const {
+    if(symbol >= shardOf_.size() || shardOf_[symbol] == NoShard){
+        std::ostringstream oss;
+        oss << "MatchingEngine: unknown symbol " << symbol;
+        throw std::logic_error(oss.str());
+    }
+    return shardOf_[symbol];
+}
+
+bool MatchingEngine::TrySubmit(const Command& command){
+    return shards_[ShardOf(command.symbol_)]->TrySubmit(command);
+}
+
+bool MatchingEngine::TryPoll(ExecutionReport& report){
+    const std::size_t count = shards_.size();
+    for(std::size_t i = 0; i < count; ++i){
+        std::size_t shard = pollCursor_;
+        pollCursor_ = (pollCursor_ + 1 == count) ? 0 : pollCursor_ + 1;
+        if(shards_[shard]->TryPoll(report))
+            return true;
+    }
+    return false;
+}
+
+const MatchingThread::Book& MatchingEngine::GetBook(SymbolId symbol) const {
+    return shards_[ShardOf(symbol)]->GetBook(symbol);
+}
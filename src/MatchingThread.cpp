@@ -0,0 +1,153 @@
+#include "MatchingThread.h"
+#include "Orderbook.inl"
+#include <stdexcept>
+
+#if defined(__linux__)
+  #include <pthread.h>
+  #include <sched.h>
+#elif defined(_WIN32)
+  #include <windows.h>
+#endif
+
+namespace {
+
+// Best effort: a failed pin leaves the thread floating
+void PinCurrentThread(int cpu){
+    if(cpu < 0)
+        return;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    (void)pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#elif defined(_WIN32)
+    (void)SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{ 1 } << cpu);
+#endif
+}
+
+}
+
+MatchingThread::MatchingThread(const MatchingThreadConfig& config)
+    : bookConfig_{ config.book_ }
+    , inbound_{ config.inboundCapacity_ }
+    , outbound_{ config.outboundCapacity_ }
+    , cpu_{ config.cpu_ }
+    , events_{ config.events_ }
+{
+    fills_.reserve(64);
+}
+
+MatchingThread::~MatchingThread(){
+    Stop();
+}
+
+void MatchingThread::AddSymbol(SymbolId symbol){
+    if(Running())
+        throw std::logic_error("MatchingThread: symbols must be added before Start");
+    if(symbol >= books_.size())
+        books_.resize(static_cast<std::size_t>(symbol) + 1);
+    if(!books_[symbol])
+        books_[symbol] = std::make_unique<Book>(bookConfig_, ReportEventListener{ events_ ? this : nullptr });
+}
+
+void MatchingThread::Start(){
+    if(running_.exchange(true))
+        return;
+    thread_ = std::thread([this]{ Run(); });
+}
+
+void MatchingThread::Stop(){
+    running_.store(false, std::memory_order_release);
+    if(thread_.joinable())
+        thread_.join();
+}
+
+void MatchingThread::Run(){
+    PinCurrentThread(cpu_);
+
+    Command command;
+    std::uint32_t spins = 0;
+    for(;;){
+        if(inbound_.TryPop(command)){
+            Process(command);
+            spins = 0;
+            continue;
+        }
+        // Stop drains everything submitted before it was called
+        if(!running_.load(std::memory_order_acquire) && inbound_.Empty())
+            break;
+        SpinWait(spins);
+    }
+}
+
+void MatchingThread::Process(const Command& command){
+    ExecutionReport report;
+    report.command_ = command.type_;
+    report.symbol_ = command.symbol_;
+    report.orderId_ = command.orderId_;
+    report.tag_ = command.tag_;
+
+    fills_.clear();
+    bool rejected = !HasSymbol(command.symbol_);
+    if(!rejected){
+        Book& book = *books_[command.symbol_];
+        current_ = &report;
+        // A command the book refuses (e.g. a price outside a ladder book's
+        // band) is rejected rather than escaping and terminating the thread
+        try{
+            switch(command.type_){
+            case CommandType::Add:
+                book.AddOrder(Order{ command.orderType_, command.orderId_, command.side_, command.price_, command.quantity_ }, fills_);
+                break;
+            case CommandType::Cancel:
+                book.CancelOrder(command.orderId_);
+                break;
+            case CommandType::Modify:
+                book.MatchOrder(OrderModify{ command.orderId_, command.side_, command.price_, command.quantity_ }, fills_);
+                break;
+            }
+        }
+        catch(const std::exception&){
+            rejected = true;
+        }
+    }
+
+    report.type_ = ReportType::Fill;
+    for(const Trade& trade : fills_){
+        report.bid_ = trade.GetBidTrade();
+        report.ask_ = trade.GetAskTrade();
+        Publish(report);
+    }
+
+    if(rejected){
+        report.type_ = ReportType::Reject;
+        report.bid_ = {};
+        report.ask_ = {};
+        Publish(report);
+    }
+
+    report.type_ = ReportType::Done;
+    report.fillCount_ = static_cast<std::uint32_t>(fills_.size());
+    report.bid_ = {};
+    report.ask_ = {};
+    Publish(report);
+}
+
+void MatchingThread::Publish(const ExecutionReport& report){
+    std::uint32_t spins = 0;
+    while(!outbound_.TryPush(report))
+        SpinWait(spins);
+}
+
+void MatchingThread::PublishEvent(const Event& event){
+    ExecutionReport report = *current_;
+    report.type_ = ReportType::Event;
+    report.event_ = event;
+    Publish(report);
+}
+
+void ReportEventListener::OnEvent(const Event& e){
+    thread_->PublishEvent(e);
+}
+
+template class BasicOrderbook<ReportEventListener>;
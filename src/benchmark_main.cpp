@@ -3,11 +3,20 @@
 // Writes snapshot_golden_<scenario>.txt and snapshot_replay_<scenario>.txt and compares them
 // Writes event logs: events_golden_<scenario>.csv and events_replay_<scenario>.csv
 
-#include "benchmark.h"   
+#include "Benchmark.h"   
 #include "Orderbook.h"
 #include "Order.h"
 #include "OrderModify.h"
+#include "MatchingThread.h"
+#include "MatchingEngine.h"
+#include "BinaryTrace.h"
+#include "EventJournal.h"
+#include "CommandLog.h"
 #include "bench_config.h"
+#include "workload_generator.h"
+#include "LatencyHistogram.h"
+#include "EngineProbes.h"
+#include "TscClock.h"
 #include <iostream>
 #include <fstream>
 #include <memory>
@@ -17,51 +26,117 @@
 #include <string>
 #include <chrono>
 #include <algorithm>
+#include <cmath>
 #include <sstream>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <iterator>
+#include <span>
+#include <filesystem>
 
 // ---------- small helpers ----------
 using namespace std::chrono;
 
 // ---------- latency instrumentation ----------
+// Samples are taken on TscClock (calibrated once in main): fenced TSC reads
+// when the TSC is invariant, steady_clock otherwise. Cross-op stamps
+// (pipeline / WAL tags) use the unfenced lat_now().
 #ifndef ENABLE_LATENCY
 #define ENABLE_LATENCY 1
 #endif
 
-using LatClock = std::chrono::steady_clock;
-using LatNS = std::chrono::nanoseconds;
+inline uint64_t lat_now() { return TscClock::Now(); }
+inline uint64_t lat_ns(uint64_t ticks) { return TscClock::ToNs(ticks); }
 
-inline uint64_t lat_now_ns() {
-    return std::chrono::duration_cast<LatNS>(
-        LatClock::now().time_since_epoch()
-    ).count();
-}
+inline void lat_record(LatencyHistogram &hist, uint64_t ns) { hist.Record(ns); }
 
 #if ENABLE_LATENCY
-#define LAT_START(tag) uint64_t tag##_lat_start = lat_now_ns()
-#define LAT_END(vec, tag) vec.push_back(lat_now_ns() - tag##_lat_start)
+#define LAT_START(tag) uint64_t tag##_lat_start = TscClock::Start()
+#define LAT_ELAPSED(tag) TscClock::ToNs(TscClock::Stop() - tag##_lat_start)
 #else
 #define LAT_START(tag)
-#define LAT_END(vec, tag)
+#define LAT_ELAPSED(tag) uint64_t{0}
+#endif
+#define LAT_END(sink, tag) lat_record(sink, LAT_ELAPSED(tag))
+
+// ---------- allocation counting hook ----------
+// Replaces global operator new/delete so each phase can report heap
+// allocations per op (steady-state engine paths should report zero).
+#ifndef ENABLE_ALLOC_COUNT
+#define ENABLE_ALLOC_COUNT 1
+#endif
+
+static std::atomic<uint64_t> g_alloc_count{0};
+
+inline uint64_t alloc_count() {
+    return g_alloc_count.load(std::memory_order_relaxed);
+}
+
+#if ENABLE_ALLOC_COUNT
+// The full replaceable set (plain / array, nothrow, aligned), so no form
+// goes uncounted and every delete matches its own new. The helpers stay out
+// of line so GCC does not pair an inlined free() with operator new
+[[gnu::noinline]] static void* counted_alloc(std::size_t size) noexcept {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+[[gnu::noinline]] static void counted_free(void* p) noexcept { std::free(p); }
+
+[[gnu::noinline]] static void* counted_alloc(std::size_t size, std::align_val_t align) noexcept {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t a = static_cast<std::size_t>(align);
+    size = size ? (size + a - 1) / a * a : a;   // aligned_alloc wants a multiple
+#if defined(_WIN32)
+    return _aligned_malloc(size, a);
+#else
+    return std::aligned_alloc(a, size);
+#endif
+}
+[[gnu::noinline]] static void counted_free(void* p, std::align_val_t) noexcept {
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(std::size_t size) {
+    if (void* p = counted_alloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) {
+    if (void* p = counted_alloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size); }
+void* operator new(std::size_t size, std::align_val_t align) {
+    if (void* p = counted_alloc(size, align)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size, std::align_val_t align) {
+    if (void* p = counted_alloc(size, align)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return counted_alloc(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return counted_alloc(size, align); }
+
+void operator delete(void* p) noexcept { counted_free(p); }
+void operator delete[](void* p) noexcept { counted_free(p); }
+void operator delete(void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete[](void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+void operator delete(void* p, std::align_val_t align) noexcept { counted_free(p, align); }
+void operator delete[](void* p, std::align_val_t align) noexcept { counted_free(p, align); }
+void operator delete(void* p, std::size_t, std::align_val_t align) noexcept { counted_free(p, align); }
+void operator delete[](void* p, std::size_t, std::align_val_t align) noexcept { counted_free(p, align); }
+void operator delete(void* p, std::align_val_t align, const std::nothrow_t&) noexcept { counted_free(p, align); }
+void operator delete[](void* p, std::align_val_t align, const std::nothrow_t&) noexcept { counted_free(p, align); }
 #endif
 
-static const std::vector<uint64_t> LAT_BUCKETS_NS = {
-    100,        // 100 ns
-    200,
-    500,
-    1'000,     // 1 µs
-    2'000,
-    5'000,
-    10'000,    // 10 µs
-    20'000,
-    50'000,
-    100'000,   // 100 µs
-    200'000,
-    500'000,
-    1'000'000, // 1 ms
-    2'000'000,
-    5'000'000,
-    10'000'000 // 10 ms+
-};
 
 struct PhaseMetrics 
 {
@@ -70,8 +145,10 @@ struct PhaseMetrics
     uint64_t ops = 0;
     uint64_t ns = 0;
     uint64_t cycles = 0;
+    uint64_t allocs = 0;
     double avg_ns() const { return ops ? (double)ns / ops : 0.0; }
     double cycles_per_op() const { return ops ? (double)cycles / ops : 0.0; }
+    double allocs_per_op() const { return ops ? (double)allocs / ops : 0.0; }
 };
 
 static void print_metrics_console(const PhaseMetrics &m) 
@@ -81,6 +158,7 @@ static void print_metrics_console(const PhaseMetrics &m)
     std::cout << "  total: " << (m.ns / 1e6) << " ms (" << m.ns << " ns)\n";
     std::cout << "  avg/op: " << std::fixed << std::setprecision(2) << m.avg_ns() << " ns\n";
     std::cout << "  cycles/op: " << std::fixed << std::setprecision(2) << m.cycles_per_op() << "\n";
+    std::cout << "  allocs/op: " << std::fixed << std::setprecision(4) << m.allocs_per_op() << "\n";
     std::cout << "  throughput: " << std::fixed << std::setprecision(2) << (m.ops / (m.ns / 1e9)) << " ops/s\n\n";
 }
 
@@ -92,28 +170,232 @@ static void append_csv(std::ofstream &f, const PhaseMetrics &m)
       << m.ns << "," 
       << m.cycles << "," 
       << std::fixed << std::setprecision(2) << m.avg_ns() << "," 
-      << std::fixed << std::setprecision(2) << m.cycles_per_op() << "\n";
+      << std::fixed << std::setprecision(2) << m.cycles_per_op() << ","
+      << std::fixed << std::setprecision(4) << m.allocs_per_op() << "\n";
+}
+
+// latency_summary.csv columns; the offered / achieved rates are only filled
+// on open-loop rows
+static const char *const LATENCY_SUMMARY_HEADER =
+    "scenario,op,ops,samples,p50_ns,p90_ns,p99_ns,p999_ns,p9999_ns,max_ns,offered_ops_s,achieved_ops_s";
+
+// "samples,p50,p90,p99,p99.9,p99.99,max" columns of a latency CSV row
+static void write_latency_columns(std::ostream &out, const LatencyHistogram &h)
+{
+    out << h.Count() << "," << h.Percentile(0.50) << "," << h.Percentile(0.90) << ","
+        << h.Percentile(0.99) << "," << h.Percentile(0.999) << "," << h.Percentile(0.9999) << "," << h.Max();
+}
+
+// Rows of an existing latency_summary.csv: the open-loop ones (scenario
+// openloop-*) or all others. Rows under a different header (an older
+// layout) are dropped rather than mislabelled.
+static std::vector<std::string> read_latency_summary(const std::string &path, bool openloop)
+{
+    std::vector<std::string> rows;
+    std::ifstream in(path);
+    std::string line;
+    if (std::getline(in, line) && line == LATENCY_SUMMARY_HEADER) {
+        while (std::getline(in, line))
+            if (!line.empty() && line.starts_with("openloop-") == openloop) rows.push_back(line);
+    }
+    return rows;
+}
+
+static void print_latency(const std::string &label, const LatencyHistogram &h)
+{
+    std::cout << "[LATENCY " << label << "] "
+              << "samples=" << h.Count() << " "
+              << "p50=" << h.Percentile(0.50) << " ns "
+              << "p90=" << h.Percentile(0.90) << " ns "
+              << "p99=" << h.Percentile(0.99) << " ns "
+              << "p99.9=" << h.Percentile(0.999) << " ns "
+              << "p99.99=" << h.Percentile(0.9999) << " ns "
+              << "max=" << h.Max() << " ns\n";
+}
+
+#if OME_ENGINE_PROBES
+// Per op type and engine sub-phase, from the random_ops probe table. Probe
+// ticks are on the calibrated TscClock.
+static void write_phase_breakdown(const BenchConfig &cfg, const std::string &scenario, const EngineProbeTable &table)
+{
+    static std::ofstream out(cfg.paths.results + "phase_breakdown.csv");
+    if (out.tellp() == 0)
+        out << "scenario,op,phase,ops,calls,ticks,ns,ns_per_op,share_pct\n";
+
+    const double ns_per_tick = 1.0 / TscClock::Calibration().ticksPerNs_;
+    for (size_t o = 0; o < ProbeOpCount; ++o) {
+        uint64_t ops = table.ops_[o];
+        if (ops == 0) continue;
+        uint64_t op_ticks = 0;
+        for (size_t p = 0; p < EnginePhaseCount; ++p) op_ticks += table.ticks_[o][p];
+
+        const char *op = ProbeOpName(static_cast<ProbeOp>(o));
+        std::cout << "[BREAKDOWN " << op << "] " << ops << " ops, " << std::fixed << std::setprecision(1)
+                  << op_ticks * ns_per_tick / ops << " ns/op:";
+        for (size_t p = 0; p < EnginePhaseCount; ++p) {
+            uint64_t ticks = table.ticks_[o][p];
+            double share = op_ticks ? 100.0 * ticks / op_ticks : 0.0;
+            const char *phase = EnginePhaseName(static_cast<EnginePhase>(p));
+            out << scenario << "," << op << "," << phase << "," << ops << "," << table.calls_[o][p] << ","
+                << ticks << "," << std::fixed << std::setprecision(0) << ticks * ns_per_tick << ","
+                << std::setprecision(2) << ticks * ns_per_tick / ops << "," << share << "\n";
+            if (share >= 1.0) std::cout << " " << phase << "=" << std::setprecision(0) << share << "%";
+        }
+        std::cout << "\n";
+    }
+    out.flush();
+}
+#endif
+
+// Cost of an empty LAT_START / LAT_END pair, i.e. the floor under every
+// per-op sample; subtract its p50 (or min) to correct short ops
+static LatencyHistogram measure_probe_overhead(uint64_t samples)
+{
+    LatencyHistogram h;
+    for (uint64_t i = 0; i < samples; ++i) {
+        LAT_START(p);
+        LAT_END(h, p);
+    }
+    return h;
+}
+
+static void print_clock(const ClockCalibration &c, const LatencyHistogram &overhead)
+{
+    // Mean cost of the unfenced read used by the engine probes and tags
+    const uint64_t READS = 1'000'000;
+    uint64_t start = TscClock::Start(), sink = 0;
+    for (uint64_t i = 0; i < READS; ++i) sink += TscClock::Now();
+    double read_ns = static_cast<double>(TscClock::ToNs(TscClock::Stop() - start)) / READS;
+    volatile uint64_t keep = sink; (void)keep;
+
+    std::cout << "[CLOCK] source=" << ClockSourceName(c.source_)
+              << " invariant_tsc=" << (c.invariantTsc_ ? "yes" : "no")
+              << std::fixed << std::setprecision(4) << " ticks/ns=" << c.ticksPerNs_
+              << std::setprecision(3) << " spread=" << c.spreadPct_ << "%\n";
+    std::cout << "[CLOCK] probe overhead: min=" << overhead.Min() << " ns p50=" << overhead.Percentile(0.50)
+              << " ns p99=" << overhead.Percentile(0.99) << " ns; unfenced read="
+              << std::setprecision(1) << read_ns << " ns\n\n";
+}
+
+// ---------- op-stream helpers ----------
+// Per-book generator state: live ids eligible for cancel / modify
+struct OpStreamState {
+    std::vector<uint32_t> ids;
+    uint32_t next_id = 6'000'000;
+};
+
+// ~55% adds (90% GTC, 5% IOC, 5% market), ~35% cancels, ~10% modifies
+static BenchOp next_op(OpStreamState &st, std::mt19937_64 &rng, Price minPrice, Price maxPrice, uint64_t i)
+{
+    std::uniform_int_distribution<int> price_dist(minPrice, maxPrice);
+    std::uniform_int_distribution<int> qty_dist(1, 10);
+    std::uniform_real_distribution<double> choice(0.0, 1.0);
+
+    Side s = (i & 1) ? Side::Buy : Side::Sell;
+    double r = choice(rng);
+    if (r < 0.35 && !st.ids.empty()) {
+        size_t idx = rng() % st.ids.size();
+        BenchOp op{BenchOp::Cancel, OrderType::GoodTillCancel, s, st.ids[idx], 0, 0};
+        st.ids[idx] = st.ids.back(); st.ids.pop_back();
+        return op;
+    }
+    if (r < 0.45 && !st.ids.empty()) {
+        return {BenchOp::Modify, OrderType::GoodTillCancel, s, st.ids[rng() % st.ids.size()], price_dist(rng), static_cast<Quantity>(qty_dist(rng))};
+    }
+    double t = choice(rng);
+    OrderType type = t < 0.90 ? OrderType::GoodTillCancel : t < 0.95 ? OrderType::ImmediateOrCancel : OrderType::Market;
+    st.ids.push_back(st.next_id);
+    return {BenchOp::Add, type, s, st.next_id++, price_dist(rng), static_cast<Quantity>(qty_dist(rng))};
+}
+
+// Order-entry flow for the op-stream phases: next_op's uniform flow, or the
+// --workload generator (one independent stream per symbol / phase)
+class OpSource {
+    OpStreamState st_;
+    std::unique_ptr<WorkloadGenerator> gen_;
+    Price min_price_, max_price_;
+public:
+    OpSource(const BenchConfig &cfg, Price minPrice, Price maxPrice, uint64_t stream = 0)
+        : min_price_(minPrice), max_price_(maxPrice) {
+        if (cfg.workload) gen_ = std::make_unique<WorkloadGenerator>(*cfg.workload, minPrice, maxPrice, st_.next_id, stream);
+    }
+    BenchOp next(std::mt19937_64 &rng, uint64_t i) {
+        return gen_ ? gen_->Next() : next_op(st_, rng, min_price_, max_price_, i);
+    }
+    // Pre-loaded depth the uniform flow may later cancel / modify
+    void track(uint32_t id) { st_.ids.push_back(id); }
+    WorkloadGenerator *generator() { return gen_.get(); }
+};
+
+// Non-crossing depth order: uniform bids below / asks above the middle of
+// the band, or the workload's passive depth around its mid
+static BenchOp resting_op(OpSource &src, std::mt19937_64 &rng, uint32_t id, bool buy,
+                          std::uniform_int_distribution<int> &bid_px, std::uniform_int_distribution<int> &ask_px,
+                          std::uniform_int_distribution<int> &qty_dist)
+{
+    Side side = buy ? Side::Buy : Side::Sell;
+    if (WorkloadGenerator *gen = src.generator()) return gen->Resting(id, side);
+    return {BenchOp::Add, OrderType::GoodTillCancel, side, id, buy ? bid_px(rng) : ask_px(rng), static_cast<Quantity>(qty_dist(rng))};
+}
+
+static std::vector<BenchOp> make_op_stream(const BenchConfig &cfg, uint64_t count, std::mt19937_64 &rng,
+                                           Price minPrice, Price maxPrice, uint64_t stream = 0)
+{
+    std::vector<BenchOp> ops;
+    ops.reserve(count);
+    OpSource src(cfg, minPrice, maxPrice, stream);
+    for (uint64_t i = 0; i < count; ++i)
+        ops.push_back(src.next(rng, i));
+    return ops;
+}
+
+// Replays ops into any book variant; returns elapsed ns / cycles in m
+template <typename Book>
+static void run_event_cost_ops(Book &ob, const std::vector<BenchOp> &ops, Trades &fills, PhaseMetrics &m)
+{
+    Timer t;
+    for (const BenchOp &op : ops) {
+        fills.clear();
+        switch (op.kind) {
+        case BenchOp::Add:    ob.AddOrder(Order(op.type, op.id, op.side, op.price, op.qty), fills); break;
+        case BenchOp::Cancel: ob.CancelOrder(op.id); break;
+        case BenchOp::Modify: ob.MatchOrder(OrderModify(op.id, op.side, op.price, op.qty), fills); break;
+        }
+    }
+    m.ns = t.nanoseconds();
+    m.cycles = t.cycles();
+    m.ops = ops.size();
 }
 
 // ---------- trace helpers ----------
-static void trace_write_header(std::ofstream &trace, uint64_t seed, const std::string &scenario) {
-    trace << "# seed=" << seed << ",scenario=" << scenario << "\n";
+// Correctness runs write the CSV trace and its binary twin side by side
+struct TraceOut {
+    std::ofstream csv;
+    BinaryTraceWriter bin;
+};
+
+static void trace_write_header(TraceOut &trace, uint64_t seed, const std::string &scenario) {
+    trace.csv << "# seed=" << seed << ",scenario=" << scenario << "\n";
 }
 
-static void trace_write_add(std::ofstream &trace, uint32_t id, int orderType, int side, int price, int qty) {
-    trace << "ADD," << id << "," << orderType << "," << side << "," << price << "," << qty << "\n";
+static void trace_write_add(TraceOut &trace, uint32_t id, int orderType, int side, int price, int qty) {
+    trace.csv << "ADD," << id << "," << orderType << "," << side << "," << price << "," << qty << "\n";
+    trace.bin.WriteAdd(id, static_cast<OrderType>(orderType), static_cast<Side>(side), price, qty);
 }
 
-static void trace_write_cancel(std::ofstream &trace, uint32_t id) {
-    trace << "CANCEL," << id << "\n";
+static void trace_write_cancel(TraceOut &trace, uint32_t id) {
+    trace.csv << "CANCEL," << id << "\n";
+    trace.bin.WriteCancel(id);
 }
 
-static void trace_write_match(std::ofstream &trace) {
-    trace << "MATCH\n";
+static void trace_write_match(TraceOut &trace) {
+    trace.csv << "MATCH\n";
+    trace.bin.WriteMatch();
 }
 
-static void trace_write_modify(std::ofstream &trace, uint32_t id, int side, int price, int qty) {
-    trace << "MODIFY," << id << "," << side << "," << price << "," << qty << "\n";
+static void trace_write_modify(TraceOut &trace, uint32_t id, int side, int price, int qty) {
+    trace.csv << "MODIFY," << id << "," << side << "," << price << "," << qty << "\n";
+    trace.bin.WriteModify(id, static_cast<Side>(side), price, qty);
 }
 
 // ---------- snapshot helpers ----------
@@ -167,12 +449,32 @@ static bool compare_event_logs(const std::string &a, const std::string &b, std::
     return compare_snapshots(a, b, diffOut);
 }
 
+// ---------- event journal helpers ----------
+// events_<kind>_<scenario>.csv -> events_<kind>_<scenario>.bin
+static std::string journal_path(const std::string &csvFile)
+{
+    return csvFile.substr(0, csvFile.rfind(".csv")) + ".bin";
+}
+
+// Flushes the journal and renders it as the CSV compare_event_logs diffs
+static void close_and_decode_journal(EventJournal &journal, const std::string &csvFile)
+{
+    try {
+        journal.Close();
+        DecodeEventJournalToCsv(journal_path(csvFile), csvFile);
+    } catch (const std::exception &ex) {
+        std::cerr << "[EVENTS] " << ex.what() << "\n";
+    }
+}
+
 // ---------- replay trace into fresh Orderbook (returns snapshot filename) ----------
 // Modified to also write event log for replay (gated behind ENABLE_EVENT_LOGGING)
 static void replay_trace_and_write_snapshot(const std::string &traceFile,
                                             const std::string &outSnapshotFile,
                                             const std::string &eventsReplayFile,
-                                            bool enableEventLogging) 
+                                            bool enableEventLogging,
+                                            const OrderbookConfig &bookConfig,
+                                            PhaseMetrics *metrics = nullptr) 
 {
     std::ifstream in(traceFile);
     if (!in) {
@@ -180,43 +482,31 @@ static void replay_trace_and_write_snapshot(const std::string &traceFile,
         return;
     }
 
-    Orderbook ob; // fresh instance
+    Orderbook ob(bookConfig); // fresh instance, same layout as the golden run
     if(enableEventLogging)
         ob.EnableEvents(true);
 
-    // prepare replay event log using shared_ptr to keep stream alive safely
-    std::shared_ptr<std::ofstream> eventsReplayPtr;
+    // replay events go to a binary journal, decoded to eventsReplayFile at the end
+    EventJournal eventsReplay;
     if (enableEventLogging) {
-        eventsReplayPtr = std::make_shared<std::ofstream>(eventsReplayFile);
-        if (eventsReplayPtr && eventsReplayPtr->is_open()) {
-            *eventsReplayPtr << "# columns=seq,type,order_id,order_id2,price,qty,side\n";
-            ob.SetObserver([eventsReplayPtr](const Event &ev) {
-                try {
-                    (*eventsReplayPtr) << ev.to_csv() << "\n";
-                } catch (const std::exception &ex) {
-                    std::cerr << "[REPLAY] Observer write failed: " << ex.what() << "\n";
-                } catch (...) {
-                    std::cerr << "[REPLAY] Observer write failed: unknown exception\n";
-                }
-            });
-        } else {
-            std::cerr << "[REPLAY] Warning: could not open events replay file: " << eventsReplayFile << "\n";
+        try {
+            eventsReplay.Open(journal_path(eventsReplayFile));
+            ob.SetObserver([&eventsReplay](const Event &ev) { eventsReplay.Append(ev); });
+        } catch (const std::exception &ex) {
+            std::cerr << "[REPLAY] Warning: " << ex.what() << "\n";
         }
     }
 
     std::string line;
     uint64_t lineno = 0;
     uint64_t ops_executed = 0;
-    const uint64_t PROGRESS_EVERY = 5000; // print progress periodically
+    const uint64_t PROGRESS_EVERY = 100'000; // print progress periodically
+    Timer t;
 
     while (std::getline(in, line)) {
         ++lineno;
         if (line.empty() || line[0] == '#') continue;
 
-        if ((lineno & 1023) == 0) { 
-            std::cout << "[REPLAY] reading line " << lineno << " (ops " << ops_executed << ")\n";
-        }
-
         std::istringstream iss(line);
         std::string op;
         try {
@@ -282,13 +572,18 @@ static void replay_trace_and_write_snapshot(const std::string &traceFile,
         }
     } 
 
+    if (metrics) {
+        metrics->ns = t.nanoseconds();
+        metrics->cycles = t.cycles();
+        metrics->ops = ops_executed;
+    }
     std::cout << "[REPLAY] Finished reading trace; processed " << ops_executed << " ops (lines read " << lineno << ")\n";
 
     // Unregister observer before closing stream
     ob.SetObserver(nullptr);
 
-    if (eventsReplayPtr && eventsReplayPtr->is_open()) {
-        eventsReplayPtr->close();
+    if (eventsReplay.IsOpen()) {
+        close_and_decode_journal(eventsReplay, eventsReplayFile);
     }
 
     // Write final snapshot
@@ -296,11 +591,784 @@ static void replay_trace_and_write_snapshot(const std::string &traceFile,
     std::cout << "[REPLAY] Wrote replay snapshot to " << outSnapshotFile << "\n";
 }
 
-// ---------- small util to extract id from OrderPointer ----------
-static uint32_t safe_get_order_id(const OrderPointer &p) 
+// ---------- replay binary trace (mmap) into fresh Orderbook ----------
+// Timed from mapping the file to the last record; no per-record allocation
+static void replay_binary_trace_and_write_snapshot(const std::string &traceBinFile,
+                                                   const std::string &outSnapshotFile,
+                                                   const OrderbookConfig &bookConfig,
+                                                   PhaseMetrics &m)
+{
+    try {
+        Orderbook ob(bookConfig);
+        Trades fills;
+        fills.reserve(64);
+        uint64_t a0 = alloc_count();
+        Timer t;
+        MappedTrace trace(traceBinFile);
+        m.ops = ReplayTraceRecords(ob, trace.Records(), fills);
+        m.ns = t.nanoseconds();
+        m.cycles = t.cycles();
+        m.allocs = alloc_count() - a0;
+        write_snapshot(outSnapshotFile, ob);
+    } catch (const std::exception &ex) {
+        std::cerr << "[REPLAY] Binary replay failed: " << ex.what() << "\n";
+    }
+}
+
+static void print_replay_throughput(const PhaseMetrics &csvM, const PhaseMetrics &binM)
+{
+    auto ops_per_sec = [](const PhaseMetrics &m) { return m.ns ? m.ops / (m.ns / 1e9) : 0.0; };
+    std::cout << "[REPLAY] " << csvM.scenario << ": csv " << std::fixed << std::setprecision(0) << ops_per_sec(csvM)
+              << " ops/s, binary " << ops_per_sec(binM) << " ops/s (x" << std::setprecision(1)
+              << (ops_per_sec(csvM) > 0 ? ops_per_sec(binM) / ops_per_sec(csvM) : 0.0) << ")\n";
+}
+
+// ---------- pipeline mode (gateway thread -> matching thread) ----------
+static Command to_command(const BenchOp &op, uint64_t tag)
+{
+    Command c;
+    c.type_ = op.kind == BenchOp::Add ? CommandType::Add
+            : op.kind == BenchOp::Cancel ? CommandType::Cancel : CommandType::Modify;
+    c.orderType_ = op.type;
+    c.side_ = op.side;
+    c.orderId_ = op.id;
+    c.price_ = op.price;
+    c.quantity_ = op.qty;
+    c.tag_ = tag;
+    return c;
+}
+
+struct PipelineLatency {
+    LatencyHistogram fill;   // enqueue -> fill report received
+    LatencyHistogram done;   // enqueue -> Done report received
+};
+
+// Streams ops through a MatchingThread from the calling (gateway) thread.
+// max_in_flight bounds commands submitted but not yet acknowledged: 1 gives
+// unloaded round-trip latency, a large value gives sustained throughput.
+// Every command is tagged with its enqueue time; reports are drained on the
+// same thread so both latencies share one clock.
+static PhaseMetrics run_pipeline(const std::string &name, const std::vector<BenchOp> &ops,
+                                 const MatchingThreadConfig &mtc, size_t max_in_flight,
+                                 PipelineLatency &lat)
+{
+    lat.fill.Reset(); lat.done.Reset();
+
+    MatchingThread engine(mtc);
+    engine.AddSymbol(0);
+    engine.Start();
+
+    PhaseMetrics m{"pipeline", name, ops.size()};
+    uint64_t a0 = alloc_count();
+    Timer t;
+
+    size_t next = 0, acked = 0;
+    uint32_t spins = 0;
+    ExecutionReport r;
+    while (acked < ops.size()) {
+        bool progressed = false;
+        if (next < ops.size() && next - acked < max_in_flight
+            && engine.TrySubmit(to_command(ops[next], lat_now()))) {
+            ++next;
+            progressed = true;
+        }
+        while (engine.TryPoll(r)) {
+            uint64_t now = lat_now();
+            if (r.type_ == ReportType::Fill) {
+                lat.fill.Record(lat_ns(now - r.tag_));
+            } else if (r.type_ == ReportType::Done) {
+                lat.done.Record(lat_ns(now - r.tag_));
+                ++acked;
+            }
+            progressed = true;
+        }
+        if (progressed) spins = 0; else SpinWait(spins);
+    }
+
+    m.ns = t.nanoseconds();
+    m.cycles = t.cycles();
+    m.allocs = alloc_count() - a0;
+    engine.Stop();
+    return m;
+}
+
+static int run_pipeline_benchmark(const BenchConfig &cfg)
 {
-    if (!p) return 0;
-    return p->GetOrderId();
+    std::cout << "[MODE] PIPELINE (gateway thread -> SPSC ring -> matching thread)\n";
+    SetHighPriority();
+
+    const uint64_t OPS = 1'000'000;
+    std::mt19937_64 rng(123456789ULL);
+
+    MatchingThreadConfig mtc;
+    mtc.book_.layout_ = cfg.book == BookChoice::Ladder ? BookLayout::Ladder : BookLayout::Map;
+    mtc.book_.minPrice_ = 1;
+    mtc.book_.maxPrice_ = 1000;
+    mtc.book_.orderCapacity_ = OPS;
+    mtc.cpu_ = cfg.matching_cpu;
+    if (mtc.cpu_ < 0 && std::thread::hardware_concurrency() > 1)
+        mtc.cpu_ = 1;   // keep the matching thread off core 0 by default
+
+    std::cout << "Matching thread cpu: " << (mtc.cpu_ < 0 ? std::string("unpinned") : std::to_string(mtc.cpu_))
+              << ", hardware threads: " << std::thread::hardware_concurrency() << "\n";
+
+    auto ops = make_op_stream(cfg, OPS, rng, mtc.book_.minPrice_, mtc.book_.maxPrice_);
+
+    std::ofstream csv(cfg.paths.results + "pipeline_results.csv");
+    csv << "scenario,phase,ops,total_ns,total_cycles,avg_ns,cycles_per_op,allocs_per_op\n";
+    std::ofstream lat_csv(cfg.paths.results + "latency_pipeline.csv");
+    lat_csv << "phase,kind,samples,p50_ns,p90_ns,p99_ns,p999_ns,p9999_ns,max_ns\n";
+
+    struct Run { const char *name; size_t in_flight; };
+    for (const Run &run : {Run{"round_trip", 1}, Run{"saturated", mtc.inboundCapacity_}}) {
+        auto lat = std::make_unique<PipelineLatency>();
+        PhaseMetrics m = run_pipeline(run.name, ops, mtc, run.in_flight, *lat);
+        print_metrics_console(m); append_csv(csv, m);
+
+        for (const auto &[kind, h] : {std::pair<const char *, const LatencyHistogram *>{"fill", &lat->fill},
+                                      std::pair<const char *, const LatencyHistogram *>{"done", &lat->done}}) {
+            print_latency(std::string("pipeline ") + run.name + " enqueue->" + kind, *h);
+            lat_csv << run.name << "," << kind << ",";
+            write_latency_columns(lat_csv, *h);
+            lat_csv << "\n";
+        }
+        std::cout << "\n";
+    }
+
+    std::cout << "Pipeline results written to pipeline_results.csv and latency_pipeline.csv\n";
+    return 0;
+}
+
+// ---------- shard scaling mode (multi-symbol MatchingEngine) ----------
+// Symbol ranks 0..n-1 with P(rank k) proportional to 1 / (k + 1)^s
+class ZipfSampler {
+    std::vector<double> cdf_;
+public:
+    ZipfSampler(size_t n, double s) : cdf_(n) {
+        double sum = 0.0;
+        for (size_t k = 0; k < n; ++k) cdf_[k] = (sum += 1.0 / std::pow(static_cast<double>(k + 1), s));
+        for (double &c : cdf_) c /= sum;
+    }
+    size_t operator()(std::mt19937_64 &rng) const {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        size_t k = std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+        return std::min(k, cdf_.size() - 1);
+    }
+};
+
+// Submits every command and waits for all Done reports; the gateway drains
+// reports whenever a shard's ring is full so neither side can stall
+static PhaseMetrics run_engine(MatchingEngine &engine, const std::string &scenario, const std::string &phase,
+                               const std::vector<Command> &commands)
+{
+    PhaseMetrics m{scenario, phase, commands.size()};
+    uint64_t a0 = alloc_count();
+    Timer t;
+
+    size_t next = 0, acked = 0;
+    uint32_t spins = 0;
+    ExecutionReport r;
+    while (acked < commands.size()) {
+        bool progressed = false;
+        for (int burst = 0; burst < 64 && next < commands.size() && engine.TrySubmit(commands[next]); ++burst) {
+            ++next;
+            progressed = true;
+        }
+        while (engine.TryPoll(r)) {
+            acked += (r.type_ == ReportType::Done);
+            progressed = true;
+        }
+        if (progressed) spins = 0; else SpinWait(spins);
+    }
+
+    m.ns = t.nanoseconds();
+    m.cycles = t.cycles();
+    m.allocs = alloc_count() - a0;
+    return m;
+}
+
+static int run_shard_benchmark(const BenchConfig &cfg)
+{
+    std::cout << "[MODE] SHARD SCALING (multi-symbol engine, Zipf symbol activity)\n";
+    SetHighPriority();
+
+    const uint64_t OPS = 2'000'000;
+    const size_t SYMBOLS = cfg.symbols;
+    const double ZIPF_S = 1.0;
+    const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    const size_t MAX_SHARDS = cfg.shards > 0 ? cfg.shards : std::max(1u, hw - 1);   // leave a core for the gateway
+
+    OrderbookConfig bookConfig;
+    bookConfig.layout_ = cfg.book == BookChoice::Ladder ? BookLayout::Ladder : BookLayout::Map;
+    bookConfig.minPrice_ = 1;
+    bookConfig.maxPrice_ = 1000;
+    bookConfig.orderCapacity_ = 4096;
+
+    // One op stream per symbol, interleaved by Zipf-drawn symbol rank
+    std::mt19937_64 rng(123456789ULL);
+    ZipfSampler zipf(SYMBOLS, ZIPF_S);
+    std::vector<OpSource> sources;
+    sources.reserve(SYMBOLS);
+    for (size_t sym = 0; sym < SYMBOLS; ++sym) sources.emplace_back(cfg, bookConfig.minPrice_, bookConfig.maxPrice_, sym);
+    std::vector<uint64_t> per_symbol(SYMBOLS, 0);
+    std::vector<Command> commands;
+    commands.reserve(OPS);
+    for (uint64_t i = 0; i < OPS; ++i) {
+        size_t sym = zipf(rng);
+        Command c = to_command(sources[sym].next(rng, per_symbol[sym]++), 0);
+        c.symbol_ = static_cast<SymbolId>(sym);
+        commands.push_back(c);
+    }
+
+    std::string scenario = "zipf-" + std::to_string(SYMBOLS) + "sym";
+    std::cout << scenario << ": " << OPS << " commands, hottest symbol "
+              << std::fixed << std::setprecision(1) << 100.0 * per_symbol[0] / OPS << "% of flow, "
+              << hw << " hardware threads\n\n";
+
+    std::ofstream csv(cfg.paths.results + "shard_results.csv");
+    csv << "scenario,phase,ops,total_ns,total_cycles,avg_ns,cycles_per_op,allocs_per_op\n";
+
+    std::vector<size_t> shard_counts;
+    for (size_t k = 1; k < MAX_SHARDS; k *= 2) shard_counts.push_back(k);
+    shard_counts.push_back(MAX_SHARDS);
+
+    double base_tput = 0.0;
+    for (size_t k : shard_counts) {
+        MatchingEngineConfig ec;
+        ec.book_ = bookConfig;
+        ec.shardCount_ = k;
+        ec.firstCpu_ = (k < hw) ? 1 : -1;   // gateway keeps core 0 when there is room
+        MatchingEngine engine(ec);
+        for (size_t sym = 0; sym < SYMBOLS; ++sym)
+            engine.AddSymbol(static_cast<SymbolId>(sym));   // rank order: hot symbols dealt across shards
+
+        std::vector<uint64_t> shard_load(k, 0);
+        for (size_t sym = 0; sym < SYMBOLS; ++sym) shard_load[engine.ShardOf(static_cast<SymbolId>(sym))] += per_symbol[sym];
+
+        engine.Start();
+        PhaseMetrics m = run_engine(engine, scenario, "shards_" + std::to_string(k), commands);
+        engine.Stop();
+
+        print_metrics_console(m); append_csv(csv, m);
+        double tput = m.ops / (m.ns / 1e9);
+        if (k == 1) base_tput = tput;
+        uint64_t max_load = *std::max_element(shard_load.begin(), shard_load.end());
+        std::cout << "[SHARDS] " << k << " shard(s): " << std::fixed << std::setprecision(0) << tput << " ops/s"
+                  << ", scaling x" << std::setprecision(2) << (base_tput > 0 ? tput / base_tput : 0.0)
+                  << ", busiest shard " << std::setprecision(1) << 100.0 * max_load / OPS << "% of flow\n\n";
+    }
+
+    std::cout << "Shard results written to shard_results.csv\n";
+    return 0;
+}
+
+// ---------- restart mode (snapshot + trace tail) ----------
+static void write_binary_trace(const std::string &path, uint64_t seed, const std::string &scenario,
+                               const std::vector<BenchOp> &ops)
+{
+    BinaryTraceWriter writer;
+    writer.Open(path, seed, scenario);
+    for (const BenchOp &op : ops) {
+        switch (op.kind) {
+        case BenchOp::Add:    writer.WriteAdd(op.id, op.type, op.side, op.price, op.qty); break;
+        case BenchOp::Cancel: writer.WriteCancel(op.id); break;
+        case BenchOp::Modify: writer.WriteModify(op.id, op.side, op.price, op.qty); break;
+        }
+    }
+    writer.Close();
+}
+
+static bool files_identical(const std::string &a, const std::string &b)
+{
+    std::ifstream fa(a, std::ios::binary), fb(b, std::ios::binary);
+    if (!fa || !fb) return false;
+    return std::equal(std::istreambuf_iterator<char>(fa), std::istreambuf_iterator<char>(),
+                      std::istreambuf_iterator<char>(fb), std::istreambuf_iterator<char>());
+}
+
+// Head: cfg.restart_orders non-crossing GTC orders plus 100k mixed ops;
+// tail: 100k more mixed ops continuing the same flow. The continuous run
+// replays head + tail; the restarted run loads the snapshot taken after the
+// head and replays only the tail. Final full-state snapshots must be equal.
+static int run_restart_benchmark(const BenchConfig &cfg)
+{
+    std::cout << "[MODE] RESTART (snapshot + trace tail)\n";
+    SetHighPriority();
+
+    const uint64_t ORDERS = cfg.restart_orders;
+    const uint64_t HEAD_OPS = 100'000;
+    const uint64_t TAIL_OPS = 100'000;
+    const uint64_t seed = 123456789ULL;
+    const std::string scenario = "restart-" + std::to_string(ORDERS);
+
+    OrderbookConfig bookConfig;
+    bookConfig.layout_ = cfg.book == BookChoice::Ladder ? BookLayout::Ladder : BookLayout::Map;
+    bookConfig.minPrice_ = 1;
+    bookConfig.maxPrice_ = 1000;
+    bookConfig.orderCapacity_ = ORDERS + HEAD_OPS + TAIL_OPS;
+
+    // Resting depth: bids below the mid, asks above, so none of it crosses
+    std::mt19937_64 rng(seed);
+    std::vector<BenchOp> head, tail;
+    head.reserve(ORDERS + HEAD_OPS);
+    tail.reserve(TAIL_OPS);
+    std::uniform_int_distribution<int> bid_px(1, 499), ask_px(501, 1000), qty_dist(1, 100);
+    OpSource src(cfg, bookConfig.minPrice_, bookConfig.maxPrice_);
+    for (uint64_t i = 0; i < ORDERS; ++i) {
+        BenchOp op = resting_op(src, rng, static_cast<uint32_t>(i + 1), (i & 1), bid_px, ask_px, qty_dist);
+        src.track(op.id);
+        head.push_back(op);
+    }
+    for (uint64_t i = 0; i < HEAD_OPS; ++i) head.push_back(src.next(rng, i));
+    for (uint64_t i = 0; i < TAIL_OPS; ++i) tail.push_back(src.next(rng, i));
+
+    const std::string headTrace = cfg.paths.traces + "trace_" + scenario + "_head.bin";
+    const std::string tailTrace = cfg.paths.traces + "trace_" + scenario + "_tail.bin";
+    const std::string snapFile = cfg.paths.snapshots_golden + "state_" + scenario + ".bin";
+    const std::string finalContinuous = cfg.paths.snapshots_golden + "state_" + scenario + "_final_continuous.bin";
+    const std::string finalRestarted = cfg.paths.snapshots_replay + "state_" + scenario + "_final_restarted.bin";
+
+    std::ofstream csv(cfg.paths.results + "restart_results.csv");
+    csv << "scenario,phase,ops,total_ns,total_cycles,avg_ns,cycles_per_op,allocs_per_op\n";
+    auto report = [&](const PhaseMetrics &m) { print_metrics_console(m); append_csv(csv, m); };
+
+    try {
+        write_binary_trace(headTrace, seed, scenario, head);
+        write_binary_trace(tailTrace, seed, scenario, tail);
+        Trades fills;
+        fills.reserve(1024);
+
+        // Continuous run: rebuild from the head trace, snapshot, then the tail
+        PhaseMetrics rebuildM{scenario, "rebuild_from_trace"}, saveM{scenario, "snapshot_save"};
+        PhaseMetrics tailContM{scenario, "tail_continuous"};
+        size_t book_orders = 0;
+        {
+            Orderbook ob(bookConfig);
+            {
+                MappedTrace trace(headTrace);
+                Timer t;
+                rebuildM.ops = ReplayTraceRecords(ob, trace.Records(), fills);
+                rebuildM.ns = t.nanoseconds(); rebuildM.cycles = t.cycles();
+            }
+            book_orders = ob.Size();
+            {
+                Timer t;
+                ob.SaveSnapshot(snapFile);
+                saveM.ns = t.nanoseconds(); saveM.cycles = t.cycles();
+                saveM.ops = book_orders;
+            }
+            {
+                MappedTrace trace(tailTrace);
+                Timer t;
+                tailContM.ops = ReplayTraceRecords(ob, trace.Records(), fills);
+                tailContM.ns = t.nanoseconds(); tailContM.cycles = t.cycles();
+            }
+            ob.SaveSnapshot(finalContinuous);
+        }
+
+        // Restarted run: load the snapshot, then only the tail
+        PhaseMetrics loadM{scenario, "snapshot_load"}, tailM{scenario, "tail_after_restore"};
+        {
+            Orderbook ob(bookConfig);
+            {
+                Timer t;
+                ob.LoadSnapshot(snapFile);
+                loadM.ns = t.nanoseconds(); loadM.cycles = t.cycles();
+                loadM.ops = ob.Size();
+            }
+            {
+                MappedTrace trace(tailTrace);
+                Timer t;
+                tailM.ops = ReplayTraceRecords(ob, trace.Records(), fills);
+                tailM.ns = t.nanoseconds(); tailM.cycles = t.cycles();
+            }
+            ob.SaveSnapshot(finalRestarted);
+        }
+
+        for (const auto *m : {&rebuildM, &saveM, &tailContM, &loadM, &tailM}) report(*m);
+
+        std::ifstream snap(snapFile, std::ios::binary | std::ios::ate);
+        double mb = snap ? snap.tellg() / 1e6 : 0.0;
+        std::cout << "[RESTART] book of " << book_orders << " orders, snapshot " << std::fixed << std::setprecision(1) << mb << " MB"
+                  << ", save " << std::setprecision(2) << saveM.ns / 1e6 << " ms"
+                  << ", load " << loadM.ns / 1e6 << " ms"
+                  << " (" << std::setprecision(1) << saveM.avg_ns() << " / " << loadM.avg_ns() << " ns per order)\n";
+        std::cout << "[RESTART] recovery: snapshot+tail " << std::setprecision(2) << (loadM.ns + tailM.ns) / 1e6
+                  << " ms vs full replay " << (rebuildM.ns + tailContM.ns) / 1e6 << " ms\n";
+
+        if (files_identical(finalContinuous, finalRestarted))
+            std::cout << "RESTART OK for scenario " << scenario << "\n";
+        else
+            std::cerr << "RESTART MISMATCH for scenario " << scenario << ": final snapshots differ\n";
+    } catch (const std::exception &ex) {
+        std::cerr << "[RESTART] failed: " << ex.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "Restart results written to restart_results.csv\n";
+    return 0;
+}
+
+// ---------- WAL mode (write-ahead command log, group commit) ----------
+// Every command goes through WriteAheadBook; its commit latency runs from
+// just before Append until the group holding it has been fsync'd.
+struct WalRun { std::string phase; size_t group; std::chrono::microseconds interval; };
+
+static int run_wal_benchmark(const BenchConfig &cfg)
+{
+    std::cout << "[MODE] WAL (write-ahead command log, group commit)\n";
+    SetHighPriority();
+
+    const uint64_t OPS = cfg.wal_ops;
+    const std::string scenario = "wal-" + std::to_string(OPS);
+
+    OrderbookConfig bookConfig;
+    bookConfig.layout_ = cfg.book == BookChoice::Ladder ? BookLayout::Ladder : BookLayout::Map;
+    bookConfig.minPrice_ = 1;
+    bookConfig.maxPrice_ = 1000;
+    bookConfig.orderCapacity_ = OPS;
+
+    std::mt19937_64 rng(123456789ULL);
+    std::vector<Command> commands;
+    commands.reserve(OPS);
+    for (const BenchOp &op : make_op_stream(cfg, OPS, rng, bookConfig.minPrice_, bookConfig.maxPrice_))
+        commands.push_back(to_command(op, 0));
+
+    std::ofstream csv(cfg.paths.results + "wal_results.csv");
+    csv << "scenario,phase,ops,total_ns,total_cycles,avg_ns,cycles_per_op,allocs_per_op\n";
+    std::ofstream lat_csv(cfg.paths.results + "latency_wal.csv");
+    lat_csv << "phase,group_size,commits,samples,p50_ns,p90_ns,p99_ns,p999_ns,p9999_ns,max_ns\n";
+
+    // Reference: the same flow with no log in front of the book
+    Trades fills;
+    fills.reserve(1024);
+    {
+        Orderbook ob(bookConfig);
+        ob.EnableEvents(true);
+        PhaseMetrics m{scenario, "no_log", OPS};
+        Timer t;
+        for (const Command &c : commands) { ApplyCommand(ob, c, fills); fills.clear(); }
+        m.ns = t.nanoseconds(); m.cycles = t.cycles();
+        print_metrics_console(m); append_csv(csv, m);
+    }
+
+    // Count-driven groups (the interval never fires) plus one time-driven run
+    const auto never = std::chrono::microseconds(std::chrono::hours(1));
+    std::vector<WalRun> runs;
+    for (size_t g : {1, 8, 64, 512, 4096}) runs.push_back({"group_" + std::to_string(g), g, never});
+    runs.push_back({"interval_200us", OPS, std::chrono::microseconds(200)});
+
+    bool all_ok = true;
+    try {
+        for (const WalRun &run : runs) {
+            const std::string logPath = cfg.paths.traces + "wal_" + scenario + "_" + run.phase + ".log";
+            const std::string liveSnap = cfg.paths.snapshots_golden + "state_" + scenario + "_" + run.phase + ".bin";
+            const std::string recoveredSnap = cfg.paths.snapshots_replay + "state_" + scenario + "_" + run.phase + ".bin";
+
+            std::vector<uint64_t> enqueued(OPS + 1);
+            auto lat = std::make_unique<LatencyHistogram>();
+            PhaseMetrics m{scenario, run.phase, OPS};
+            uint64_t commits = 0;
+            {
+                Orderbook ob(bookConfig);
+                ob.EnableEvents(true);
+                CommandLog log;
+                log.Open(logPath, CommandLogConfig{run.group, run.interval, true});
+                WriteAheadBook<Orderbook> wal(ob, log);
+
+                uint64_t durable = 0;
+                auto collect = [&] {
+                    uint64_t now = lat_now();
+                    for (; durable < log.DurableLsn(); ++durable) lat->Record(lat_ns(now - enqueued[durable + 1]));
+                };
+
+                uint64_t a0 = alloc_count();
+                Timer t;
+                for (const Command &c : commands) {
+                    enqueued[log.LastLsn() + 1] = lat_now();
+                    wal.Apply(c, fills);
+                    fills.clear();
+                    if (log.DurableLsn() != durable) collect();
+                }
+                log.Commit();
+                collect();
+                m.ns = t.nanoseconds(); m.cycles = t.cycles();
+                m.allocs = alloc_count() - a0;
+                commits = log.CommitCount();
+                log.Close();
+                ob.SaveSnapshot(liveSnap);
+            }
+
+            PhaseMetrics rm{scenario, "recover_" + run.phase};
+            {
+                Orderbook ob(bookConfig);
+                ob.EnableEvents(true);
+                Timer t;
+                rm.ops = RecoverCommandLog(ob, logPath, fills);
+                rm.ns = t.nanoseconds(); rm.cycles = t.cycles();
+                ob.SaveSnapshot(recoveredSnap);
+            }
+
+            for (const auto *pm : {&m, &rm}) { print_metrics_console(*pm); append_csv(csv, *pm); }
+
+            std::cout << "[WAL] " << run.phase << ": " << std::fixed << std::setprecision(0) << m.ops / (m.ns / 1e9) << " ops/s, "
+                      << commits << " fsyncs (" << std::setprecision(1) << static_cast<double>(OPS) / std::max<uint64_t>(1, commits)
+                      << " cmds each)\n";
+            print_latency("wal " + run.phase + " commit", *lat);
+            lat_csv << run.phase << "," << run.group << "," << commits << ",";
+            write_latency_columns(lat_csv, *lat);
+            lat_csv << "\n";
+
+            if (rm.ops == OPS && files_identical(liveSnap, recoveredSnap)) {
+                std::cout << "WAL RECOVERY OK for " << run.phase << "\n\n";
+            } else {
+                std::cerr << "WAL RECOVERY MISMATCH for " << run.phase << ": recovered " << rm.ops << " of " << OPS << " commands\n\n";
+                all_ok = false;
+            }
+        }
+    } catch (const std::exception &ex) {
+        std::cerr << "[WAL] failed: " << ex.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "WAL results written to wal_results.csv and latency_wal.csv\n";
+    return all_ok ? 0 : 1;
+}
+
+// ---------- batch mode (Orderbook::ProcessBatch size sweep) ----------
+// Resting depth is loaded untimed, then the mixed flow is applied either one
+// command at a time or through ProcessBatch in chunks of B commands. Every
+// run must end in the same full-state snapshot with the same fills.
+static int run_batch_benchmark(const BenchConfig &cfg)
+{
+    std::cout << "[MODE] BATCH (ProcessBatch throughput vs batch size)\n";
+    SetHighPriority();
+
+    const uint64_t ORDERS = cfg.depth_orders;
+    const uint64_t OPS = 1'000'000;
+    const uint64_t seed = 123456789ULL;
+    const std::string scenario = "batch-" + std::to_string(ORDERS);
+
+    OrderbookConfig bookConfig;
+    bookConfig.layout_ = cfg.book == BookChoice::Ladder ? BookLayout::Ladder : BookLayout::Map;
+    bookConfig.minPrice_ = 1;
+    bookConfig.maxPrice_ = 1000;
+    bookConfig.orderCapacity_ = ORDERS + OPS;
+
+    std::mt19937_64 rng(seed);
+    std::vector<Command> depth, flow;
+    depth.reserve(ORDERS);
+    flow.reserve(OPS);
+    std::uniform_int_distribution<int> bid_px(1, 499), ask_px(501, 1000), qty_dist(1, 100);
+    OpSource src(cfg, bookConfig.minPrice_, bookConfig.maxPrice_);
+    for (uint64_t i = 0; i < ORDERS; ++i) {
+        BenchOp op = resting_op(src, rng, static_cast<uint32_t>(i + 1), (i & 1), bid_px, ask_px, qty_dist);
+        src.track(op.id);
+        depth.push_back(to_command(op, 0));
+    }
+    for (uint64_t i = 0; i < OPS; ++i)
+        flow.push_back(to_command(src.next(rng, i), 0));
+
+    std::ofstream csv(cfg.paths.results + "batch_results.csv");
+    csv << "scenario,phase,ops,total_ns,total_cycles,avg_ns,cycles_per_op,allocs_per_op\n";
+
+    struct Outcome { size_t fills = 0; uint64_t volume = 0; };
+    auto run = [&](const std::string &phase, size_t batch, const std::string &snapPath, Outcome &out) {
+        Orderbook ob(bookConfig);
+        ob.EnableEvents(cfg.enable_events);
+        Trades fills;
+        fills.reserve(4096);
+        ob.ProcessBatch(depth, fills);
+
+        PhaseMetrics m{scenario, phase, OPS};
+        uint64_t a0 = alloc_count();
+        Timer t;
+        if (batch == 0) {
+            for (const Command &c : flow) {
+                ApplyCommand(ob, c, fills);
+                out.fills += fills.size();
+                for (const Trade &tr : fills) out.volume += tr.GetBidTrade().quantity_;
+                fills.clear();
+            }
+        } else {
+            std::span<const Command> all(flow);
+            for (size_t i = 0; i < all.size(); i += batch) {
+                ob.ProcessBatch(all.subspan(i, std::min(batch, all.size() - i)), fills);
+                out.fills += fills.size();
+                for (const Trade &tr : fills) out.volume += tr.GetBidTrade().quantity_;
+                fills.clear();
+            }
+        }
+        m.ns = t.nanoseconds(); m.cycles = t.cycles();
+        m.allocs = alloc_count() - a0;
+        ob.SaveSnapshot(snapPath);
+        return m;
+    };
+
+    bool all_ok = true;
+    try {
+        const std::string baseSnap = cfg.paths.snapshots_golden + "state_" + scenario + "_one_by_one.bin";
+        Outcome base;
+        PhaseMetrics bm = run("one_by_one", 0, baseSnap, base);
+        print_metrics_console(bm); append_csv(csv, bm);
+        const double base_tput = bm.ops / (bm.ns / 1e9);
+
+        for (size_t batch : {1, 4, 16, 64, 256, 1024, 4096}) {
+            const std::string phase = "batch_" + std::to_string(batch);
+            const std::string snap = cfg.paths.snapshots_replay + "state_" + scenario + "_" + phase + ".bin";
+            Outcome out;
+            PhaseMetrics m = run(phase, batch, snap, out);
+            print_metrics_console(m); append_csv(csv, m);
+
+            double tput = m.ops / (m.ns / 1e9);
+            std::cout << "[BATCH] " << phase << ": " << std::fixed << std::setprecision(0) << tput << " ops/s (x"
+                      << std::setprecision(2) << tput / base_tput << " vs one-by-one)\n";
+            if (out.fills == base.fills && out.volume == base.volume && files_identical(baseSnap, snap)) {
+                std::cout << "BATCH SNAPSHOT OK for " << phase << "\n\n";
+            } else {
+                std::cerr << "BATCH SNAPSHOT MISMATCH for " << phase << "\n\n";
+                all_ok = false;
+            }
+        }
+    } catch (const std::exception &ex) {
+        std::cerr << "[BATCH] failed: " << ex.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "Batch results written to batch_results.csv\n";
+    return all_ok ? 0 : 1;
+}
+
+// ---------- open-loop mode (fixed offered rate) ----------
+// Back-to-back timing starts each op when the previous one returns, so a slow
+// op hides the delay it imposes on the ops queued behind it (coordinated
+// omission). Here every op has an intended send time on a pre-generated
+// schedule: the loop waits for it, or runs late when behind, and latency is
+// measured from the intended time, so a stall is charged to every op it
+// delays. Service time (the op's own execution) is recorded alongside.
+
+// Replaces the open-loop rows of latency_summary.csv and keeps the rest, so
+// perf and open-loop runs share one file in either order.
+static void write_openloop_summary(const BenchConfig &cfg, const std::vector<std::string> &rows)
+{
+    const std::string path = cfg.paths.results + "latency_summary.csv";
+    std::vector<std::string> kept = read_latency_summary(path, false);
+    std::ofstream out(path);
+    out << LATENCY_SUMMARY_HEADER << "\n";
+    for (const std::string &line : kept) out << line << "\n";
+    for (const std::string &line : rows) out << line << "\n";
+}
+
+static int run_openloop_benchmark(const BenchConfig &cfg)
+{
+    std::cout << "[MODE] OPENLOOP (fixed-rate schedule, latency from intended send time)\n";
+    SetHighPriority();
+
+    const uint64_t ORDERS = cfg.depth_orders;
+    const uint64_t seed = 123456789ULL;
+    const uint64_t max_rate = *std::max_element(cfg.openloop_rates.begin(), cfg.openloop_rates.end());
+    const uint64_t MAX_OPS = std::max<uint64_t>(1, max_rate * cfg.openloop_ms / 1000);
+
+    OrderbookConfig bookConfig;
+    bookConfig.layout_ = cfg.book == BookChoice::Ladder ? BookLayout::Ladder : BookLayout::Map;
+    bookConfig.minPrice_ = 1;
+    bookConfig.maxPrice_ = 1000;
+    bookConfig.orderCapacity_ = ORDERS + MAX_OPS;
+
+    // One flow for every rate; each rate replays its prefix on a fresh book
+    std::mt19937_64 rng(seed);
+    std::vector<Command> depth, flow;
+    std::vector<uint64_t> arrivals;
+    depth.reserve(ORDERS);
+    flow.reserve(MAX_OPS);
+    arrivals.reserve(MAX_OPS);
+    std::uniform_int_distribution<int> bid_px(1, 499), ask_px(501, 1000), qty_dist(1, 100);
+    OpSource src(cfg, bookConfig.minPrice_, bookConfig.maxPrice_);
+    for (uint64_t i = 0; i < ORDERS; ++i) {
+        BenchOp op = resting_op(src, rng, static_cast<uint32_t>(i + 1), (i & 1), bid_px, ask_px, qty_dist);
+        src.track(op.id);
+        depth.push_back(to_command(op, 0));
+    }
+    for (uint64_t i = 0; i < MAX_OPS; ++i) {
+        BenchOp op = src.next(rng, i);
+        arrivals.push_back(op.arrival_ns);
+        flow.push_back(to_command(op, 0));
+    }
+
+    // Evenly spaced sends by default; a modelled workload keeps its arrival
+    // process (bursts, gaps) rescaled to each offered mean rate
+    const bool modelled = src.generator() != nullptr;
+    const double ticks_per_ns = TscClock::Calibration().ticksPerNs_;
+
+    std::ofstream csv(cfg.paths.results + "openloop_results.csv");
+    csv << "scenario,phase,ops,total_ns,total_cycles,avg_ns,cycles_per_op,allocs_per_op\n";
+    const std::string scenario = "openloop-" + std::to_string(ORDERS);
+
+    std::vector<std::string> summary_rows;
+    std::vector<uint64_t> due;
+    for (uint64_t rate : cfg.openloop_rates) {
+        const uint64_t ops = std::clamp<uint64_t>(rate * cfg.openloop_ms / 1000, 1, MAX_OPS);
+        const double gap_ns = 1e9 / double(rate);
+        // mean model gap over this rate's prefix of the flow
+        const double modelled_gap_ns = ops > 1 ? double(arrivals[ops - 1] - arrivals.front()) / double(ops - 1) : 0.0;
+        due.resize(ops);
+        for (uint64_t i = 0; i < ops; ++i) {
+            double ns = modelled && modelled_gap_ns > 0 ? double(arrivals[i] - arrivals.front()) * gap_ns / modelled_gap_ns
+                                                        : double(i) * gap_ns;
+            due[i] = static_cast<uint64_t>(ns * ticks_per_ns);
+        }
+
+        Orderbook ob(bookConfig);
+        ob.EnableEvents(cfg.enable_events);
+        Trades fills;
+        fills.reserve(4096);
+        ob.ProcessBatch(depth, fills);
+        fills.clear();
+
+        auto intended = std::make_unique<LatencyHistogram>();
+        auto service = std::make_unique<LatencyHistogram>();
+        PhaseMetrics m{scenario, "rate_" + std::to_string(rate), ops};
+        uint64_t a0 = alloc_count();
+        Timer t;
+        const uint64_t t0 = lat_now();
+        uint64_t end = t0;
+        for (uint64_t i = 0; i < ops; ++i) {
+            const uint64_t send = t0 + due[i];
+            uint64_t start = lat_now();
+            while (start < send) {
+                CpuRelax();
+                start = lat_now();
+            }
+            ApplyCommand(ob, flow[i], fills);
+            fills.clear();
+            end = lat_now();
+            intended->Record(lat_ns(end - send));
+            service->Record(lat_ns(end - start));
+        }
+        m.ns = t.nanoseconds(); m.cycles = t.cycles();
+        m.allocs = alloc_count() - a0;
+        print_metrics_console(m); append_csv(csv, m);
+
+        const double achieved = double(ops) / (double(std::max<uint64_t>(1, lat_ns(end - t0))) / 1e9);
+        std::cout << "[OPENLOOP] offered=" << rate << " ops/s achieved=" << std::fixed << std::setprecision(0) << achieved
+                  << " ops/s" << (achieved < 0.97 * double(rate) ? " (saturated)" : "") << "\n";
+        print_latency("openloop " + std::to_string(rate) + "/s from intended", *intended);
+        print_latency("openloop " + std::to_string(rate) + "/s service", *service);
+        std::cout << "\n";
+
+        for (const auto &[op, h] : {std::pair<const char *, const LatencyHistogram *>{"openloop", intended.get()},
+                                    std::pair<const char *, const LatencyHistogram *>{"openloop_service", service.get()}}) {
+            std::ostringstream row;
+            row << "openloop-" << rate << "," << op << "," << ops << ",";
+            write_latency_columns(row, *h);
+            row << "," << rate << "," << std::fixed << std::setprecision(0) << achieved;
+            summary_rows.push_back(row.str());
+        }
+    }
+
+    write_openloop_summary(cfg, summary_rows);
+    std::cout << "Open-loop results written to openloop_results.csv and latency_summary.csv\n";
+    return 0;
 }
 
 // ---------- main harness ----------
@@ -316,14 +1384,92 @@ int main(int argc, char** argv)
             cfg.mode = RunMode::Correctness;
         else if (arg == "--mode=perf")
             cfg.mode = RunMode::Performance;
+        else if (arg == "--mode=pipeline")
+            cfg.mode = RunMode::Pipeline;
+        else if (arg == "--mode=shards")
+            cfg.mode = RunMode::Shards;
+        else if (arg.starts_with("--shards="))
+            cfg.shards = std::stoul(arg.substr(9));
+        else if (arg.starts_with("--symbols="))
+            cfg.symbols = std::max<size_t>(1, std::stoul(arg.substr(10)));
+        else if (arg == "--mode=restart")
+            cfg.mode = RunMode::Restart;
+        else if (arg.starts_with("--orders="))
+            cfg.restart_orders = std::stoull(arg.substr(9));
+        else if (arg == "--mode=wal")
+            cfg.mode = RunMode::Wal;
+        else if (arg.starts_with("--wal-ops="))
+            cfg.wal_ops = std::max<uint64_t>(1, std::stoull(arg.substr(10)));
+        else if (arg == "--mode=batch")
+            cfg.mode = RunMode::Batch;
+        else if (arg.starts_with("--depth="))
+            cfg.depth_orders = std::stoull(arg.substr(8));
+        else if (arg == "--mode=openloop")
+            cfg.mode = RunMode::OpenLoop;
+        else if (arg.starts_with("--rates=")) {
+            cfg.openloop_rates.clear();
+            std::stringstream rates(arg.substr(8));
+            for (std::string r; std::getline(rates, r, ',');)
+                if (!r.empty()) cfg.openloop_rates.push_back(std::max<uint64_t>(1, std::stoull(r)));
+            if (cfg.openloop_rates.empty()) {
+                std::cerr << "--rates= needs at least one rate in ops/s, e.g. --rates=500000,1000000\n";
+                return 1;
+            }
+        }
+        else if (arg.starts_with("--openloop-ms="))
+            cfg.openloop_ms = std::max<uint64_t>(1, std::stoull(arg.substr(14)));
+        else if (arg.starts_with("--workload=")) {
+            try {
+                cfg.workload = LoadWorkloadConfig(arg.substr(11));
+                std::cout << "[WORKLOAD] " << arg.substr(11) << " (seed " << cfg.workload->seed << ")\n";
+            } catch (const std::exception &ex) {
+                std::cerr << ex.what() << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--clock=steady")
+            cfg.steady_clock = true;
+        else if (arg.starts_with("--cpu="))
+            cfg.matching_cpu = std::stoi(arg.substr(6));
         else if (arg == "--events")
             cfg.enable_events = true;
         else if (arg.starts_with("--out="))
             cfg.paths.root = arg.substr(6);
+        else if (arg == "--book=map")
+            cfg.book = BookChoice::Map;
+        else if (arg == "--book=ladder")
+            cfg.book = BookChoice::Ladder;
+        else if (arg == "--book=both")
+            cfg.book = BookChoice::Both;
+    }
+
+    // --out=<root>: result CSVs go to <root>/results/, so repeated runs can
+    // be kept side by side (analysis/regression_gate.py)
+    if (cfg.paths.root != "bench") {
+        cfg.paths.results = cfg.paths.root + "/results/";
+        std::filesystem::create_directories(cfg.paths.results);
     }
 
+    // Per-op latency clock, calibrated before any mode runs
+    const ClockCalibration &clock = TscClock::Calibrate(std::chrono::milliseconds{ 50 }, !cfg.steady_clock);
+    const auto probe_overhead = std::make_unique<LatencyHistogram>(measure_probe_overhead(1'000'000));
+    print_clock(clock, *probe_overhead);
+
+    if (cfg.mode == RunMode::Pipeline)
+        return run_pipeline_benchmark(cfg);
+    if (cfg.mode == RunMode::Shards)
+        return run_shard_benchmark(cfg);
+    if (cfg.mode == RunMode::Restart)
+        return run_restart_benchmark(cfg);
+    if (cfg.mode == RunMode::Wal)
+        return run_wal_benchmark(cfg);
+    if (cfg.mode == RunMode::Batch)
+        return run_batch_benchmark(cfg);
+    if (cfg.mode == RunMode::OpenLoop)
+        return run_openloop_benchmark(cfg);
+
     // --- configuration ---
-    struct Scenario { std::string name; uint64_t bulk; uint64_t rnd_ops; };
+    struct Scenario { std::string name; uint64_t bulk; uint64_t rnd_ops; BookLayout layout = BookLayout::Map; };
 
     const bool CORRECTNESS_ONLY = (cfg.mode == RunMode::Correctness);   // Derived from CLI flags
     const bool ENABLE_EVENT_LOGGING = (cfg.enable_events && CORRECTNESS_ONLY); // set false to disable event logging for faster perf runs
@@ -373,90 +1519,124 @@ int main(int argc, char** argv)
         MATCH_FRACTION  = 0.05;
 
         WARMUP_ORDERS   = 50'000;
-        KEEP_PTRS       = false;   // avoids storing millions of shared_ptrs → prevents memory blowup
+        KEEP_PTRS       = false;   // avoids storing millions of ids → prevents memory blowup
         base_seed       = 123456789ULL;
 
         std::cout << "[MODE] PERFORMANCE BENCHMARKS\n";
     }
 
+    // Expand scenarios per requested book layout; ladder runs get a "-ladder" suffix
+    if (cfg.book != BookChoice::Map) {
+        std::vector<Scenario> expanded;
+        for (const auto &sc : scenarios) {
+            if (cfg.book == BookChoice::Both)
+                expanded.push_back(sc);
+            expanded.push_back({sc.name + "-ladder", sc.bulk, sc.rnd_ops, BookLayout::Ladder});
+        }
+        scenarios = std::move(expanded);
+    }
+
     const std::string CSV_FILE = cfg.paths.results + "bench_results.csv";
 
     std::cout << "=== OME Benchmark Harness (with trace+replay) ===\n";
     SetHighPriority();
 
     std::ofstream csv(CSV_FILE);
-    csv << "scenario,phase,ops,total_ns,total_cycles,avg_ns,cycles_per_op\n";
+    csv << "scenario,phase,ops,total_ns,total_cycles,avg_ns,cycles_per_op,allocs_per_op\n";
 
     for (const auto &sc : scenarios) {
-        uint64_t seed = base_seed ^ std::hash<std::string>{}(sc.name);
+        // Layout variants share the base scenario's seed so they replay identical flow
+        std::string baseName = sc.name.substr(0, sc.name.rfind("-ladder"));
+        uint64_t seed = base_seed ^ std::hash<std::string>{}(baseName);
         std::mt19937_64 rng(seed);
 
+        // Prices stay inside the ladder band so both layouts see the same flow
+        OrderbookConfig bookConfig;
+        bookConfig.layout_ = sc.layout;
+        bookConfig.minPrice_ = 1;
+        bookConfig.maxPrice_ = 1000;
+        bookConfig.orderCapacity_ = WARMUP_ORDERS + sc.bulk + sc.rnd_ops;
+
         // Prepare RNG and dists
-        std::uniform_int_distribution<int> price_dist(1, 1000);
+        std::uniform_int_distribution<int> price_dist(bookConfig.minPrice_, bookConfig.maxPrice_);
         std::uniform_int_distribution<int> qty_dist(1, 10);
         std::uniform_real_distribution<double> op_choice(0.0, 1.0);
 
+        // --workload: resting depth comes from the model's passive sampler and
+        // random_ops' adds / cancels / modifies from its event stream (queries
+        // and explicit matches keep their fractions)
+        std::unique_ptr<WorkloadGenerator> gen;
+        if (cfg.workload)
+            gen = std::make_unique<WorkloadGenerator>(*cfg.workload, bookConfig.minPrice_, bookConfig.maxPrice_, 2'000'000u, seed);
+        auto resting = [&](uint32_t id, Side s) -> std::pair<int, int> {
+            if (gen) {
+                BenchOp w = gen->Resting(id, s);
+                return {w.price, static_cast<int>(w.qty)};
+            }
+            int price = price_dist(rng);
+            return {price, qty_dist(rng)};
+        };
+
         std::cout << "=== Running scenario: " << sc.name << " (bulk=" << sc.bulk << ", rnd=" << sc.rnd_ops << ") ===\n";
 
         // trace file for this scenario
         std::string traceFile = cfg.paths.traces + std::string("trace_ops_") + sc.name + ".csv";
-        std::ofstream trace;
+        std::string traceBinFile = cfg.paths.traces + std::string("trace_ops_") + sc.name + ".bin";
+        TraceOut trace;
         if (!PERF_MODE) {
-            trace.open(traceFile);
+            trace.csv.open(traceFile);
+            trace.bin.Open(traceBinFile, seed, sc.name);
             trace_write_header(trace, seed, sc.name);
         }
 
         // Prepare event log for golden run (gated by ENABLE_EVENT_LOGGING)
         std::string eventsGoldenFile = cfg.paths.events_golden + std::string("events_golden_") + sc.name + ".csv";
-        std::shared_ptr<std::ofstream> eventsGoldenPtr;
+        EventJournal eventsGolden;
         if (ENABLE_EVENT_LOGGING) {
-            eventsGoldenPtr = std::make_shared<std::ofstream>(eventsGoldenFile);
-            if (eventsGoldenPtr && eventsGoldenPtr->is_open()) {
-                *eventsGoldenPtr << "# columns=seq,type,order_id,order_id2,price,qty,side\n";
-            } else {
-                std::cerr << "[SCENARIO " << sc.name << "] Warning: could not open events golden file: " << eventsGoldenFile << "\n";
-                eventsGoldenPtr.reset();
+            try {
+                eventsGolden.Open(journal_path(eventsGoldenFile));
+            } catch (const std::exception &ex) {
+                std::cerr << "[SCENARIO " << sc.name << "] Warning: " << ex.what() << "\n";
             }
         }
 
-        Orderbook ob;
+        Orderbook ob(bookConfig);
         ob.EnableEvents(cfg.enable_events);
 
-        // register observer for golden run (writes to events_golden_<scenario>.csv) if enabled
-        if (eventsGoldenPtr) {
-            ob.SetObserver([eventsGoldenPtr](const Event &ev) {
-                try {
-                    (*eventsGoldenPtr) << ev.to_csv() << "\n";
-                } catch (const std::exception &ex) {
-                    // swallow/log — we cannot let observer exceptions crash the engine
-                    std::cerr << "Observer write failed: " << ex.what() << std::endl;
-                } catch (...) {
-                    std::cerr << "Observer write failed: unknown exception\n";
-                }
-            });
+        // register observer for golden run (journal decoded to events_golden_<scenario>.csv) if enabled
+        if (eventsGolden.IsOpen()) {
+            ob.SetObserver([&eventsGolden](const Event &ev) { eventsGolden.Append(ev); });
         }
 
-        std::vector<OrderPointer> stored;
+        // Reused fill buffer: harness paths use the sink API so fills are not
+        // reallocated on every op
+        Trades fills;
+        fills.reserve(1024);
+
+        std::vector<uint32_t> stored;   // ids of orders kept for cancels/modifies
         stored.reserve(static_cast<size_t>(sc.bulk) + static_cast<size_t>(sc.rnd_ops / 4));
 
         // --- Warmup ---
         {
             Timer t;
+            uint64_t allocs0 = alloc_count();
             for (uint64_t i = 0; i < WARMUP_ORDERS; ++i) {
                 uint32_t id = static_cast<uint32_t>(10 + i);
                 Side s = (i & 1) ? Side::Buy : Side::Sell;
-                int price = price_dist(rng);
-                int qty = qty_dist(rng);
-                auto o = std::make_shared<Order>(OrderType::GoodTillCancel, id, s, price, qty);
-                ob.AddOrder(o);
+                auto [price, qty] = resting(id, s);
+                Order o(OrderType::GoodTillCancel, id, s, price, qty);
+                fills.clear(); ob.AddOrder(o, fills);
                 if (!PERF_MODE) {
                     trace_write_add(trace, id, static_cast<int>(OrderType::GoodTillCancel), static_cast<int>(s), price, qty);
                 }
-                if (KEEP_PTRS && (i & 63) == 0) stored.push_back(o);
+                if (KEEP_PTRS && (i & 63) == 0) stored.push_back(id);
             }
-            PhaseMetrics m{sc.name, "warmup", WARMUP_ORDERS, t.nanoseconds(), t.cycles()};
+            PhaseMetrics m{sc.name, "warmup", WARMUP_ORDERS, t.nanoseconds(), t.cycles(), alloc_count() - allocs0};
             print_metrics_console(m); append_csv(csv, m);
-            for (auto &p : stored) ob.CancelOrder(safe_get_order_id(p));
+            for (uint32_t id : stored) {
+                ob.CancelOrder(id);
+                if (!PERF_MODE) trace_write_cancel(trace, id);
+            }
             stored.clear();
         }
         
@@ -490,37 +1670,51 @@ int main(int argc, char** argv)
         PhaseMetrics bulkM{sc.name, "bulk_insert"};
         {
             Timer t;
+            uint64_t allocs0 = alloc_count();
             for (uint64_t i = 0; i < sc.bulk; ++i) {
                 uint32_t id = static_cast<uint32_t>(1'000'000 + i);
                 Side s = (i & 1) ? Side::Buy : Side::Sell;
-                int price = price_dist(rng);
-                int qty = qty_dist(rng);
-                auto o = std::make_shared<Order>(OrderType::GoodTillCancel, id, s, price, qty);
-                ob.AddOrder(o);
+                auto [price, qty] = resting(id, s);
+                Order o(OrderType::GoodTillCancel, id, s, price, qty);
+                fills.clear(); ob.AddOrder(o, fills);
                 if (!PERF_MODE) {
                     trace_write_add(trace, id, static_cast<int>(OrderType::GoodTillCancel), static_cast<int>(s), price, qty);
                 }
-                if (KEEP_PTRS) stored.push_back(o);
+                if (KEEP_PTRS) stored.push_back(id);
             }
             bulkM.ops = sc.bulk; bulkM.ns = t.nanoseconds(); bulkM.cycles = t.cycles();
+            bulkM.allocs = alloc_count() - allocs0;
             print_metrics_console(bulkM); append_csv(csv, bulkM);
         }
 
         std::vector<uint32_t> live_ids;
-        live_ids.reserve(stored.size());
-        for (auto &p : stored) live_ids.push_back(safe_get_order_id(p));
+        live_ids.reserve(stored.size() + sc.rnd_ops);
+        live_ids.assign(stored.begin(), stored.end());
         std::uniform_int_distribution<size_t> idx_dist(0, live_ids.empty() ? 0 : live_ids.size() - 1);
 
-        std::vector<uint64_t> lat_random_ops;
-        if (!CORRECTNESS_ONLY) {
-            lat_random_ops.reserve(sc.rnd_ops);
-        }
+        // One fixed-size histogram per op type, allocated before the timed
+        // loop. Modify samples of resting orders are also split by the path
+        // the book takes (Orderbook::ModifiesInPlace, checked untimed): resize
+        // = same side / price, no more quantity (in place); reprice = anything
+        // else (cancel / replace). Modifies of ids no longer resting are no-ops
+        // and only counted under modify.
+        struct OpLatency {
+            LatencyHistogram add, cancel, modify, query, match;
+            LatencyHistogram modify_resize, modify_reprice;
+            LatencyHistogram all;   // merged after the loop
+        };
+        auto op_lat = std::make_unique<OpLatency>();
 
         // Randomized workload mixes reads, cancels, matches, and adds
         // to simulate realistic order flow without bias toward any path.
         PhaseMetrics rndM{sc.name, "random_ops"};
+        const double cancel_fraction = gen ? 0.0 : CANCEL_FRACTION;   // the workload times its own cancels
+#if OME_ENGINE_PROBES
+        EngineProbes::Reset();
+#endif
         {
             Timer t;
+            uint64_t allocs0 = alloc_count();
             uint64_t count_adds = 0, count_cancels = 0, count_queries = 0, count_matches = 0;
             uint64_t count_modifies = 0;
             uint32_t next_add_id = static_cast<uint32_t>(2'000'000);
@@ -531,21 +1725,25 @@ int main(int argc, char** argv)
                 // Query best
                 if (r < QUERY_FRACTION) {
                     LAT_START(q);
+                    OME_PROBE_OP_BEGIN(ProbeOp::Query);
                     if ((op & 1) == 0) { volatile auto b = ob.GetBestBidPrice(); (void)b; }
                     else              { volatile auto a = ob.GetBestAskPrice(); (void)a; }
-                    LAT_END(lat_random_ops, q);
+                    OME_PROBE_OP_END();
+                    LAT_END(op_lat->query, q);
                     ++count_queries; continue;
                 }
 
                 // Cancel
-                if (r < QUERY_FRACTION + CANCEL_FRACTION) {
+                if (r < QUERY_FRACTION + cancel_fraction) {
                     uint64_t lat = 0;
                     if (!live_ids.empty()) {
                         size_t idx = idx_dist(rng) % live_ids.size();
                         uint32_t id = live_ids[idx];
                         LAT_START(c);
+                        OME_PROBE_OP_BEGIN(ProbeOp::Cancel);
                         ob.CancelOrder(id);
-                        lat = lat_now_ns() - c_lat_start;
+                        OME_PROBE_OP_END();
+                        lat = LAT_ELAPSED(c);
                         if (!PERF_MODE) {
                             trace_write_cancel(trace, id);
                         }
@@ -557,17 +1755,19 @@ int main(int argc, char** argv)
                     }else {
                         // empty cancel → measure minimal overhead (still one sample)
                         LAT_START(c);
-                        lat = lat_now_ns() - c_lat_start;
+                        lat = LAT_ELAPSED(c);
                     }
-                    lat_random_ops.push_back(lat);
+                    op_lat->cancel.Record(lat);
                     continue;
                 }
 
                 // Match explicit
-                if (r < QUERY_FRACTION + CANCEL_FRACTION + MATCH_FRACTION) {
+                if (r < QUERY_FRACTION + cancel_fraction + MATCH_FRACTION) {
                     LAT_START(m);
-                    ob.MatchOrders();
-                    LAT_END(lat_random_ops, m);
+                    OME_PROBE_OP_BEGIN(ProbeOp::Match);
+                    fills.clear(); ob.MatchOrders(fills);
+                    OME_PROBE_OP_END();
+                    LAT_END(op_lat->match, m);
                     if (!PERF_MODE) {
                         trace_write_match(trace);
                     }
@@ -575,6 +1775,44 @@ int main(int argc, char** argv)
                     continue;
                 }
 
+                // Workload op: whatever the model sends next
+                if (gen) {
+                    BenchOp w = gen->Next();
+                    fills.clear();
+                    if (w.kind == BenchOp::Cancel) {
+                        LAT_START(c);
+                        OME_PROBE_OP_BEGIN(ProbeOp::Cancel);
+                        ob.CancelOrder(w.id);
+                        OME_PROBE_OP_END();
+                        LAT_END(op_lat->cancel, c);
+                        if (!PERF_MODE) trace_write_cancel(trace, w.id);
+                        ++count_cancels;
+                    } else if (w.kind == BenchOp::Modify) {
+                        const bool resting = ob.FindOrder(w.id) != nullptr;
+                        const bool resize = ob.ModifiesInPlace(OrderModify(w.id, w.side, w.price, w.qty));
+                        LAT_START(md);
+                        OME_PROBE_OP_BEGIN(ProbeOp::Modify);
+                        ob.MatchOrder(OrderModify(w.id, w.side, w.price, w.qty), fills);
+                        OME_PROBE_OP_END();
+                        uint64_t lat = LAT_ELAPSED(md);
+                        if (!PERF_MODE) trace_write_modify(trace, w.id, static_cast<int>(w.side), w.price, w.qty);
+                        if (resting) (resize ? op_lat->modify_resize : op_lat->modify_reprice).Record(lat);
+                        op_lat->modify.Record(lat);
+                        ++count_modifies;
+                    } else {
+                        LAT_START(a);
+                        OME_PROBE_OP_BEGIN(ProbeOp::Add);
+                        ob.AddOrder(Order(w.type, w.id, w.side, w.price, w.qty), fills);
+                        OME_PROBE_OP_END();
+                        LAT_END(op_lat->add, a);
+                        if (!PERF_MODE) {
+                            trace_write_add(trace, w.id, static_cast<int>(w.type), static_cast<int>(w.side), w.price, static_cast<int>(w.qty));
+                        }
+                        ++count_adds;
+                    }
+                    continue;
+                }
+
                 // Add or Modify
                 // Occasionally pick an existing order and modify it to test MatchOrder(OrderModify)
                 if ((op % 41) == 0){
@@ -586,20 +1824,33 @@ int main(int argc, char** argv)
                         Side s = (op & 1) ? Side::Buy : Side::Sell;
                         int price = price_dist(rng);
                         int qty = qty_dist(rng);
+                        // every other modify halves what is still resting of
+                        // the order, at its own side and price
+                        const Order *resting = ob.FindOrder(id);
+                        if ((count_modifies & 1) && resting) {
+                            s = resting->GetSide();
+                            price = resting->GetPrice();
+                            qty = std::max<int>(1, static_cast<int>(resting->GetRemainingQuantity() / 2));
+                        }
                         OrderModify om(id, s, price, qty);
+                        const bool resize = ob.ModifiesInPlace(om);
+                        const bool was_resting = resting != nullptr;
                         LAT_START(md);
-                        ob.MatchOrder(om);
-                        lat = lat_now_ns() - md_lat_start;
+                        OME_PROBE_OP_BEGIN(ProbeOp::Modify);
+                        fills.clear(); ob.MatchOrder(om, fills);
+                        OME_PROBE_OP_END();
+                        lat = LAT_ELAPSED(md);
                         if (!PERF_MODE) {
                             trace_write_modify(trace, id, static_cast<int>(s), price, qty);
                         }
+                        if (was_resting) (resize ? op_lat->modify_resize : op_lat->modify_reprice).Record(lat);
                         ++count_modifies;
                     } else {
                         LAT_START(md);
-                        lat = lat_now_ns() - md_lat_start;
+                        lat = LAT_ELAPSED(md);
                     }
 
-                    lat_random_ops.push_back(lat);
+                    op_lat->modify.Record(lat);
                     continue;
                 }
 
@@ -619,102 +1870,343 @@ int main(int argc, char** argv)
                     }else if ((op % 61) == 0) type = OrderType::ImmediateOrCancel;
                     else if ((op % 43) == 0) type = OrderType::FillOrKill;
 
-                    auto o = std::make_shared<Order>(type, id, s, price, qty);
+                    Order o(type, id, s, price, qty);
                     LAT_START(a);
-                    ob.AddOrder(o);
-                    LAT_END(lat_random_ops, a);
+                    OME_PROBE_OP_BEGIN(ProbeOp::Add);
+                    fills.clear(); ob.AddOrder(o, fills);
+                    OME_PROBE_OP_END();
+                    LAT_END(op_lat->add, a);
                     if (!PERF_MODE) {
                         trace_write_add(trace, id, static_cast<int>(type), static_cast<int>(s), price, qty);
                     }
 
-                    if (KEEP_PTRS) stored.push_back(o);
-                    live_ids.push_back(safe_get_order_id(o));
-                    idx_dist = std::uniform_int_distribution<size_t>(0, live_ids.size() - 1);
+                    if (KEEP_PTRS) stored.push_back(id);
+                    // IOC / FOK / market orders never rest: only GTC ids are
+                    // cancel / modify targets
+                    if (type == OrderType::GoodTillCancel) {
+                        live_ids.push_back(id);
+                        idx_dist = std::uniform_int_distribution<size_t>(0, live_ids.size() - 1);
+                    }
                     ++count_adds;
                 }
             }
 
             rndM.ops = sc.rnd_ops; rndM.ns = t.nanoseconds(); rndM.cycles = t.cycles();
+            rndM.allocs = alloc_count() - allocs0;
             print_metrics_console(rndM); append_csv(csv, rndM);
+            if (gen) {
+                std::cout << "[WORKLOAD] adds=" << count_adds << " cancels=" << count_cancels
+                          << " modifies=" << count_modifies << " mid=" << gen->Mid()
+                          << " live=" << gen->LiveOrders() << " book=" << ob.Size()
+                          << " simulated=" << std::fixed << std::setprecision(2) << gen->NowNs() / 1e6 << " ms\n\n";
+            }
         }
 
-        if (!CORRECTNESS_ONLY && lat_random_ops.size() != sc.rnd_ops) {
+        const std::pair<const char *, const LatencyHistogram *> op_hists[] = {
+            {"add", &op_lat->add}, {"cancel", &op_lat->cancel}, {"modify", &op_lat->modify},
+            {"query", &op_lat->query}, {"match", &op_lat->match}};
+        for (const auto &[name, h] : op_hists) op_lat->all.Merge(*h);
+
+        if (!CORRECTNESS_ONLY && op_lat->all.Count() != sc.rnd_ops) {
             std::cerr << "[LATENCY ERROR] expected "
                     << sc.rnd_ops << " got "
-                    << lat_random_ops.size() << "\n";
+                    << op_lat->all.Count() << "\n";
             std::abort();
         }
 
-        std::vector<uint64_t> hist(LAT_BUCKETS_NS.size() + 1, 0);
-
-        for (uint64_t lat : lat_random_ops) {
-            size_t i = 0;
-            while (i < LAT_BUCKETS_NS.size() && lat > LAT_BUCKETS_NS[i]) {
-                ++i;
+        if (!CORRECTNESS_ONLY) {
+            print_latency("random_ops", op_lat->all);
+            for (const auto &[name, h] : op_hists) print_latency(std::string("random_ops ") + name, *h);
+            print_latency("modify resize", op_lat->modify_resize);
+            print_latency("modify reprice", op_lat->modify_reprice);
+
+            std::ofstream mf(cfg.paths.results + "latency_modify_" + sc.name + ".csv");
+            mf << "kind,samples,p50_ns,p90_ns,p99_ns,p999_ns,p9999_ns,max_ns\n";
+            mf << "resize,"; write_latency_columns(mf, op_lat->modify_resize); mf << "\n";
+            mf << "reprice,"; write_latency_columns(mf, op_lat->modify_reprice); mf << "\n";
+
+            // Non-empty buckets of the merged histogram, then its percentiles
+            std::ofstream lf(cfg.paths.results + "latency_random_ops_" + sc.name + ".csv");
+            lf << "bucket_low_ns,bucket_high_ns,count\n";
+            op_lat->all.ForEachBucket([&lf](uint64_t low, uint64_t high, uint64_t count) {
+                lf << low << "," << high << "," << count << "\n";
+            });
+            lf << "\npercentile,value_ns\n";
+            lf << "p50," << op_lat->all.Percentile(0.50) << "\n";
+            lf << "p90," << op_lat->all.Percentile(0.90) << "\n";
+            lf << "p99," << op_lat->all.Percentile(0.99) << "\n";
+            lf << "p99.9," << op_lat->all.Percentile(0.999) << "\n";
+            lf << "p99.99," << op_lat->all.Percentile(0.9999) << "\n";
+            lf << "max," << op_lat->all.Max() << "\n";
+
+            // One row per scenario and op type ("all" = every random_ops sample).
+            // The perf run owns every non-open-loop row; open-loop rows from an
+            // earlier --mode=openloop run are carried over.
+            static std::ofstream summary_csv;
+            if (!summary_csv.is_open()) {
+                const std::string path = cfg.paths.results + "latency_summary.csv";
+                std::vector<std::string> openloop_rows = read_latency_summary(path, true);
+                summary_csv.open(path);
+                summary_csv << LATENCY_SUMMARY_HEADER << "\n";
+                for (const std::string &line : openloop_rows) summary_csv << line << "\n";
+                // Empty probe pair, so each op's percentiles can be corrected
+                summary_csv << "clock_" << ClockSourceName(TscClock::Source()) << ",probe_overhead," << probe_overhead->Count() << ",";
+                write_latency_columns(summary_csv, *probe_overhead);
+                summary_csv << ",,\n";
             }
-            hist[i]++;
+            summary_csv << sc.name << ",all," << sc.rnd_ops << ",";
+            write_latency_columns(summary_csv, op_lat->all);
+            summary_csv << ",,\n";
+            for (const auto &[name, h] : op_hists) {
+                summary_csv << sc.name << "," << name << "," << sc.rnd_ops << ",";
+                write_latency_columns(summary_csv, *h);
+                summary_csv << ",,\n";
+            }
+            summary_csv.flush();
         }
 
-        uint64_t p50 = 0, p90 = 0, p99 = 0;
-
-        std::vector<uint64_t> tmp;
+#if OME_ENGINE_PROBES
+        if (!CORRECTNESS_ONLY) write_phase_breakdown(cfg, sc.name, EngineProbes::Table());
+#endif
 
-        auto percentile = [&](double p) {
-            tmp = lat_random_ops;
-            size_t idx = static_cast<size_t>(p * (tmp.size() - 1));
-            std::nth_element(tmp.begin(), tmp.begin() + idx, tmp.end());
-            return tmp[idx];
-        };
+        // Cancel-heavy: ~75% cancels of random resting orders (bulk + random_ops
+        // ids still in the book), ~25% GTC adds to keep the book populated.
+        // Perf only; only cancels that hit a resting order are sampled: a
+        // target filled by a later add misses the index and is counted apart.
+        if (PERF_MODE) {
+            const uint64_t CANCEL_HEAVY_OPS = sc.rnd_ops;
+            std::vector<uint32_t> cancel_ids;
+            cancel_ids.reserve(sc.bulk + live_ids.size() + CANCEL_HEAVY_OPS);
+            for (uint64_t i = 0; i < sc.bulk; ++i) {
+                uint32_t id = static_cast<uint32_t>(1'000'000 + i);
+                if (ob.FindOrder(id)) cancel_ids.push_back(id);
+            }
+            for (uint32_t id : live_ids)
+                if (ob.FindOrder(id)) cancel_ids.push_back(id);
 
-        if (!CORRECTNESS_ONLY && !lat_random_ops.empty()) {
-            p50 = percentile(0.50);
-            p90 = percentile(0.90);
-            p99 = percentile(0.99);
+            auto lat_cancel = std::make_unique<LatencyHistogram>();
+            uint64_t cancel_misses = 0;
+            uint32_t next_id = static_cast<uint32_t>(3'000'000);
 
-            std::cout << "[LATENCY random_ops] "
-                    << "p50=" << p50 << " ns "
-                    << "p90=" << p90 << " ns "
-                    << "p99=" << p99 << " ns\n";
+            Timer t;
+            uint64_t allocs0 = alloc_count();
+            for (uint64_t op = 0; op < CANCEL_HEAVY_OPS; ++op) {
+                if (op_choice(rng) < 0.75 && !cancel_ids.empty()) {
+                    size_t idx = rng() % cancel_ids.size();
+                    uint32_t id = cancel_ids[idx];
+                    cancel_ids[idx] = cancel_ids.back();
+                    cancel_ids.pop_back();
+                    size_t resting = ob.Size();
+                    LAT_START(c);
+                    ob.CancelOrder(id);
+                    uint64_t lat = LAT_ELAPSED(c);
+                    if (ob.Size() < resting) lat_cancel->Record(lat);
+                    else ++cancel_misses;
+                } else {
+                    uint32_t id = next_id++;
+                    Side s = (op & 1) ? Side::Buy : Side::Sell;
+                    fills.clear(); ob.AddOrder(Order(OrderType::GoodTillCancel, id, s, price_dist(rng), qty_dist(rng)), fills);
+                    cancel_ids.push_back(id);
+                }
+            }
+            PhaseMetrics cm{sc.name, "cancel_heavy", CANCEL_HEAVY_OPS, t.nanoseconds(), t.cycles(), alloc_count() - allocs0};
+            print_metrics_console(cm); append_csv(csv, cm);
+
+            print_latency("cancel_heavy", *lat_cancel);
+            std::cout << "[CANCEL_HEAVY] " << cancel_misses << " cancels missed (target already filled), not sampled\n";
+
+            std::ofstream lf(cfg.paths.results + "latency_cancel_heavy_" + sc.name + ".csv");
+            lf << "percentile,value_ns\n";
+            lf << "p50," << lat_cancel->Percentile(0.50) << "\n";
+            lf << "p90," << lat_cancel->Percentile(0.90) << "\n";
+            lf << "p99," << lat_cancel->Percentile(0.99) << "\n";
+            lf << "p99.9," << lat_cancel->Percentile(0.999) << "\n";
+            lf << "p99.99," << lat_cancel->Percentile(0.9999) << "\n";
+            lf << "max," << lat_cancel->Max() << "\n";
         }
 
-        if (!CORRECTNESS_ONLY) {
-            std::string latCsv =
-                cfg.paths.results + "latency_random_ops_" + sc.name + ".csv";
-
-            std::ofstream lf(latCsv);
-            lf << "bucket_ns,count\n";
+        // FOK-heavy: fill-or-kill orders priced through the whole opposite side.
+        // ~90% are oversized and fail admission after summing every level; the
+        // rest are small and fill. Perf only.
+        if (PERF_MODE) {
+            const uint64_t FOK_OPS = sc.rnd_ops / 2;
+            auto lat_fok = std::make_unique<LatencyHistogram>();
+            uint32_t next_id = static_cast<uint32_t>(4'000'000);
+            uint64_t fok_fills = 0;
 
-            for (size_t i = 0; i < hist.size(); ++i) {
-                if (i < LAT_BUCKETS_NS.size())
-                    lf << LAT_BUCKETS_NS[i] << "," << hist[i] << "\n";
-                else
-                    lf << "overflow," << hist[i] << "\n";
+            Timer t;
+            uint64_t allocs0 = alloc_count();
+            for (uint64_t op = 0; op < FOK_OPS; ++op) {
+                Side s = (op & 1) ? Side::Buy : Side::Sell;
+                Price limit = (s == Side::Buy) ? bookConfig.maxPrice_ : bookConfig.minPrice_;
+                Quantity qty = (op_choice(rng) < 0.9) ? 100'000'000 : static_cast<Quantity>(qty_dist(rng));
+                Order o(OrderType::FillOrKill, next_id++, s, limit, qty);
+                LAT_START(f);
+                fills.clear(); ob.AddOrder(o, fills);
+                LAT_END(*lat_fok, f);
+                if (!fills.empty()) ++fok_fills;
             }
+            PhaseMetrics fm{sc.name, "fok_heavy", FOK_OPS, t.nanoseconds(), t.cycles(), alloc_count() - allocs0};
+            print_metrics_console(fm); append_csv(csv, fm);
 
-            lf << "\npercentile,value_ns\n";
-            lf << "p50," << p50 << "\n";
-            lf << "p90," << p90 << "\n";
-            lf << "p99," << p99 << "\n";
-
-            lf.close();
+            std::cout << "[FOK] filled=" << fok_fills << " of " << FOK_OPS << "\n";
+            print_latency("fok_heavy", *lat_fok);
         }
 
-        if (!CORRECTNESS_ONLY && !lat_random_ops.empty()) {
+        // Sweep: market buys that each sweep SWEEP_LEVELS freshly posted ask
+        // levels, once through the vector-returning AddOrder and once through
+        // the sink overload with a reused buffer. Fresh book per variant so
+        // both see identical flow. Perf only; only the market orders are timed.
+        if (PERF_MODE) {
+            const uint64_t SWEEP_OPS = sc.rnd_ops / 10;
+            const int SWEEP_LEVELS = 8;
+            const Quantity LEVEL_QTY = 5;
+
+            for (bool use_sink : {false, true}) {
+                Orderbook sweepBook(bookConfig);
+                Trades sink;
+                sink.reserve(64);
+                auto lat_sweep = std::make_unique<LatencyHistogram>();
+                uint32_t next_id = static_cast<uint32_t>(5'000'000);
+                uint64_t ns = 0, cycles = 0, allocs = 0;
+
+                for (uint64_t op = 0; op < SWEEP_OPS; ++op) {
+                    Price base = bookConfig.minPrice_ + static_cast<Price>(op % 500);
+                    for (int l = 0; l < SWEEP_LEVELS; ++l) {
+                        sink.clear();
+                        sweepBook.AddOrder(Order(OrderType::GoodTillCancel, next_id++, Side::Sell, base + l, LEVEL_QTY), sink);
+                    }
+                    Order market(OrderType::Market, next_id++, Side::Buy, 0, SWEEP_LEVELS * LEVEL_QTY);
+
+                    Timer t;
+                    uint64_t allocs0 = alloc_count();
+                    LAT_START(sw);
+                    if (use_sink) {
+                        sink.clear();
+                        sweepBook.AddOrder(market, sink);
+                    } else {
+                        volatile size_t n = sweepBook.AddOrder(market).size(); (void)n;
+                    }
+                    LAT_END(*lat_sweep, sw);
+                    allocs += alloc_count() - allocs0;
+                    cycles += t.cycles(); ns += t.nanoseconds();
+                }
+
+                std::string phase = use_sink ? "sweep_sink" : "sweep_vector";
+                PhaseMetrics sm{sc.name, phase, SWEEP_OPS, ns, cycles, allocs};
+                print_metrics_console(sm); append_csv(csv, sm);
+                print_latency(phase, *lat_sweep);
+            }
+        }
 
-            static std::ofstream summary_csv(
-                cfg.paths.results + "latency_summary.csv",
-                std::ios::app
-            );
+        // Event cost: the same op stream through a book whose listener is
+        // compiled out (NullEventListener), the default Orderbook with events
+        // disabled at runtime, with events enabled into a counting observer,
+        // into the previous per-event CSV observer (to_csv + ofstream), and a
+        // JournaledOrderbook appending to a binary event journal (flushed
+        // inline, then on a background thread). Each variant runs on a fresh
+        // book three times and keeps the fastest run. Perf only.
+        if (PERF_MODE) {
+            auto ops = make_op_stream(cfg, sc.rnd_ops, rng, bookConfig.minPrice_, bookConfig.maxPrice_, seed);
+            auto best_of = [](PhaseMetrics &m, auto &&run_once) {
+                for (int rep = 0; rep < 3; ++rep) {
+                    PhaseMetrics r = m;
+                    run_once(r);
+                    if (rep == 0 || r.ns < m.ns) m = r;
+                }
+            };
+            std::string eventsFile = cfg.paths.events_golden + std::string("events_perf_") + sc.name;
 
-            if (summary_csv.tellp() == 0) {
-                summary_csv << "scenario,ops,p50_ns,p90_ns,p99_ns\n";
+            PhaseMetrics offM{sc.name, "events_compiled_out"};
+            best_of(offM, [&](PhaseMetrics &m) {
+                BasicOrderbook<NullEventListener> book(bookConfig);
+                run_event_cost_ops(book, ops, fills, m);
+            });
+            PhaseMetrics disabledM{sc.name, "events_disabled"};
+            best_of(disabledM, [&](PhaseMetrics &m) {
+                Orderbook book(bookConfig);
+                run_event_cost_ops(book, ops, fills, m);
+            });
+            PhaseMetrics onM{sc.name, "events_enabled"};
+            uint64_t event_count = 0;
+            best_of(onM, [&](PhaseMetrics &m) {
+                event_count = 0;
+                Orderbook book(bookConfig);
+                book.SetObserver([&event_count](const Event &) { ++event_count; });
+                book.EnableEvents(true);
+                run_event_cost_ops(book, ops, fills, m);
+            });
+            PhaseMetrics csvM{sc.name, "events_csv_observer"};
+            best_of(csvM, [&](PhaseMetrics &m) {
+                std::ofstream out(eventsFile + ".csv");
+                Orderbook book(bookConfig);
+                book.SetObserver([&out](const Event &ev) { out << ev.to_csv() << "\n"; });
+                book.EnableEvents(true);
+                run_event_cost_ops(book, ops, fills, m);
+            });
+            PhaseMetrics journalM{sc.name, "events_journal"};
+            PhaseMetrics journalBgM{sc.name, "events_journal_bg"};
+            try {
+                for (auto [jm, background] : {std::pair{&journalM, false}, std::pair{&journalBgM, true}}) {
+                    best_of(*jm, [&, background = background](PhaseMetrics &m) {
+                        EventJournal journal;
+                        journal.Open(eventsFile + ".bin", EventJournal::DefaultCapacity, background);
+                        JournaledOrderbook book(bookConfig, JournalEventListener{&journal});
+                        run_event_cost_ops(book, ops, fills, m);
+                        journal.Close();
+                    });
+                }
+            } catch (const std::exception &ex) {
+                std::cerr << "[EVENTS] journal variants skipped: " << ex.what() << "\n";
+            }
+            for (const auto *m : {&offM, &disabledM, &onM, &csvM, &journalM, &journalBgM}) {
+                if (m->ops) { print_metrics_console(*m); append_csv(csv, *m); }
             }
+            auto per_event = [&](const PhaseMetrics &m) {
+                return event_count ? (static_cast<double>(m.ns) - static_cast<double>(offM.ns)) / event_count : 0.0;
+            };
+            std::cout << "[EVENTS] events=" << event_count
+                      << " (" << std::fixed << std::setprecision(2) << (double)event_count / ops.size() << "/op)"
+                      << " ns/event vs compiled-out: observer=" << per_event(onM)
+                      << " csv_observer=" << per_event(csvM)
+                      << " journal=" << per_event(journalM)
+                      << " journal_bg=" << per_event(journalBgM)
+                      << "; disabled-vs-compiled-out=" << (disabledM.avg_ns() - offM.avg_ns()) << " ns/op\n";
+        }
 
-            summary_csv << sc.name << ","
-                        << sc.rnd_ops << ","
-                        << p50 << ","
-                        << p90 << ","
-                        << p99 << "\n";
+        // Trace replay: the same op stream as a binary trace (mmap replay)
+        // and as its CSV conversion (line-parsing replay). Perf only.
+        if (PERF_MODE) {
+            std::string binFile = cfg.paths.traces + std::string("trace_perf_") + sc.name + ".bin";
+            std::string csvFile = cfg.paths.traces + std::string("trace_perf_") + sc.name + ".csv";
+            std::string csvSnap = cfg.paths.snapshots_replay + std::string("snapshot_perf_csv_") + sc.name + ".txt";
+            std::string binSnap = cfg.paths.snapshots_replay + std::string("snapshot_perf_bin_") + sc.name + ".txt";
+            try {
+                BinaryTraceWriter writer;
+                writer.Open(binFile, seed, sc.name);
+                for (const BenchOp &op : make_op_stream(cfg, sc.rnd_ops, rng, bookConfig.minPrice_, bookConfig.maxPrice_, seed)) {
+                    switch (op.kind) {
+                    case BenchOp::Add:    writer.WriteAdd(op.id, op.type, op.side, op.price, op.qty); break;
+                    case BenchOp::Cancel: writer.WriteCancel(op.id); break;
+                    case BenchOp::Modify: writer.WriteModify(op.id, op.side, op.price, op.qty); break;
+                    }
+                }
+                writer.Close();
+                ConvertTraceBinaryToCsv(binFile, csvFile);
+
+                PhaseMetrics csvM{sc.name, "replay_csv"}, binM{sc.name, "replay_binary"};
+                replay_trace_and_write_snapshot(csvFile, csvSnap, "", false, bookConfig, &csvM);
+                replay_binary_trace_and_write_snapshot(binFile, binSnap, bookConfig, binM);
+                print_metrics_console(csvM); append_csv(csv, csvM);
+                print_metrics_console(binM); append_csv(csv, binM);
+                print_replay_throughput(csvM, binM);
+
+                std::string diff;
+                if (!compare_snapshots(csvSnap, binSnap, diff))
+                    std::cerr << "[REPLAY] csv / binary replay snapshots differ for " << sc.name << ":\n" << diff << "\n";
+            } catch (const std::exception &ex) {
+                std::cerr << "[REPLAY] trace replay phase skipped: " << ex.what() << "\n";
+            }
         }
 
         // Best-bid stress test
@@ -728,6 +2220,20 @@ int main(int argc, char** argv)
             print_metrics_console(qm); append_csv(csv, qm);
         }
 
+        // Top-of-book stress: best price + quantity on both sides per op
+        {
+            const uint64_t QOPS = 200'000;
+            Timer t;
+            for (uint64_t i = 0; i < QOPS; ++i) {
+                volatile auto bp = ob.GetBestBidPrice(); (void)bp;
+                volatile auto bq = ob.GetBestBidQuantity(); (void)bq;
+                volatile auto ap = ob.GetBestAskPrice(); (void)ap;
+                volatile auto aq = ob.GetBestAskQuantity(); (void)aq;
+            }
+            PhaseMetrics qm{sc.name, "tob_qty_stress", QOPS, t.nanoseconds(), t.cycles()};
+            print_metrics_console(qm); append_csv(csv, qm);
+        }
+
         // write golden snapshot
         std::string goldenSnapshot = cfg.paths.snapshots_golden + std::string("snapshot_golden_") + sc.name + ".txt";
         if (!PERF_MODE) {
@@ -738,15 +2244,21 @@ int main(int argc, char** argv)
         ob.SetObserver(nullptr);
 
         // close events golden file & trace
-        if (eventsGoldenPtr && eventsGoldenPtr->is_open()) eventsGoldenPtr->close();
-        if(!PERF_MODE)
-            trace.close();
+        if (eventsGolden.IsOpen()) close_and_decode_journal(eventsGolden, eventsGoldenFile);
+        if(!PERF_MODE) {
+            trace.csv.close();
+            trace.bin.Close();
+        }
 
         // replay trace and write replay snapshot & replay events
         std::string replaySnapshot = cfg.paths.snapshots_replay + std::string("snapshot_replay_") + sc.name + ".txt";
         std::string eventsReplayFile = cfg.paths.events_replay + std::string("events_replay_") + sc.name + ".csv";
+        std::string replayBinSnapshot = cfg.paths.snapshots_replay + std::string("snapshot_replay_bin_") + sc.name + ".txt";
         if (!PERF_MODE) {
-            replay_trace_and_write_snapshot(traceFile, replaySnapshot, eventsReplayFile, ENABLE_EVENT_LOGGING);
+            PhaseMetrics csvM{sc.name, "replay_csv"}, binM{sc.name, "replay_binary"};
+            replay_trace_and_write_snapshot(traceFile, replaySnapshot, eventsReplayFile, ENABLE_EVENT_LOGGING, bookConfig, &csvM);
+            replay_binary_trace_and_write_snapshot(traceBinFile, replayBinSnapshot, bookConfig, binM);
+            print_replay_throughput(csvM, binM);
         }
 
         // compare snapshots
@@ -759,6 +2271,13 @@ int main(int argc, char** argv)
             } else {
                 std::cout << "REPLAY OK for scenario " << sc.name << "\n";
             }
+
+            ok = compare_snapshots(goldenSnapshot, replayBinSnapshot, diff);
+            if (!ok) {
+                std::cerr << "BINARY REPLAY MISMATCH for scenario " << sc.name << ":\n" << diff << "\n";
+            } else {
+                std::cout << "BINARY REPLAY OK for scenario " << sc.name << "\n";
+            }
         }
 
         // compare event logs (optional; prints diff if mismatch)
@@ -0,0 +1,25 @@
+// event_decode_main.cpp
+// ---------------------
+// Renders a binary event journal (see EventJournal.h) as the events CSV
+// used by compare_event_logs, so journals can be diffed as text.
+//
+//   event_decode.exe <events.bin> <events.csv>
+
+#include "EventJournal.h"
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    if (argc != 3) {
+        std::cerr << "usage: " << argv[0] << " <journal.bin> <out.csv>\n";
+        return 2;
+    }
+    try {
+        std::uint64_t records = DecodeEventJournalToCsv(argv[1], argv[2]);
+        std::cout << "Decoded " << records << " events: " << argv[1] << " -> " << argv[2] << "\n";
+    } catch (const std::exception& ex) {
+        std::cerr << "event_decode: " << ex.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
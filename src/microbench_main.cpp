@@ -0,0 +1,761 @@
+// Order book microbenchmarks (make microbench)
+// Times one operation kind at a time against a pre-built book of a given
+// depth: adds, cancels by FIFO position, single fills, multi-level sweeps,
+// FOK admission, modifies and level snapshots.
+// Book setup and the untimed restore after every batch keep the book at
+// the same shape for the whole run; only the operation itself is inside
+// the fenced TscClock interval.
+// Writes microbench.csv and microbench.json to the results directory;
+// --sweep instead fits per-op cost growth over depth (depth_sweep*.csv).
+
+#include "Orderbook.h"
+#include "Order.h"
+#include "OrderModify.h"
+#include "TscClock.h"
+#include "PerfCounters.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ---------- configuration ----------
+struct MicroConfig {
+    std::vector<uint64_t> depths{ 1'000, 10'000, 100'000, 1'000'000 };  // resting orders, both sides
+    BookLayout layout = BookLayout::Map;
+    double min_time_ms = 50.0;  // timed work per repetition
+    int reps = 9;               // repetitions per case / depth
+    std::string filter;         // run only cases whose name contains this
+    std::string results = "bench/results/";
+    bool steady_clock = false;
+    bool counters = false;      // hardware miss counters per op (perf_event_open)
+
+    // --sweep: fitted per-op cost growth instead of the case table
+    bool sweep = false;
+    std::vector<std::string> series{ "levels", "per_level" };
+    uint64_t max_depth = 10'000'000;
+    size_t fixed_levels = 50;       // per_level series: levels per side
+    size_t fixed_per_level = 10;    // levels series: orders per level
+};
+
+// ---------- book fixture ----------
+// Bids rest at mid - Gap - level, asks at mid + Gap + level, `perLevel`
+// orders per level. Bids carry BidQty (room for in-place shrinks), asks
+// carry 1 so an aggressor's quantity is the number of orders it fills.
+// The fixture mirrors each bid level's FIFO so cases can pick an order by
+// position, and counts asks per level so fills can be replenished.
+constexpr Price Gap = 10;
+constexpr size_t MaxLevels = 1'000;
+constexpr size_t TargetPerLevel = 10;
+constexpr Quantity BidQty = 10;
+constexpr uint64_t Batch = 64;      // operations per timed interval
+constexpr uint64_t MinDepth = 4 * Batch;    // smallest book that can supply a batch of distinct orders
+
+// Levels / orders per level for a depth: about TargetPerLevel per level up
+// to MaxLevels levels per side
+struct BookShape {
+    size_t levels;
+    size_t perLevel;
+};
+
+static BookShape shape_for_depth(uint64_t depth) {
+    size_t perSide = std::max<uint64_t>(1, depth / 2);
+    size_t levels = std::clamp<size_t>(perSide / TargetPerLevel, 1, MaxLevels);
+    return { levels, std::max<size_t>(1, perSide / levels) };
+}
+
+class BookFixture {
+private:
+    std::unique_ptr<Orderbook> ob_;
+    size_t levels_;
+    size_t perLevel_;
+    Price mid_;
+    std::vector<std::deque<OrderId>> bidQueues_;
+    std::vector<size_t> askCounts_;
+    size_t askMissing_ = 0;
+    OrderId nextId_ = 1;
+    Trades fills_;
+    std::mt19937_64 rng_{ 42 };
+
+public:
+    BookFixture(BookShape shape, BookLayout layout)
+        : levels_{ shape.levels }, perLevel_{ shape.perLevel } {
+        // room for add_new_level's extra levels behind the deepest bid
+        Price reach = Gap + static_cast<Price>(std::max(MaxLevels, levels_) + 2 * Batch);
+        mid_ = std::max<Price>(100'000, reach + 1);
+
+        OrderbookConfig config;
+        config.layout_ = layout;
+        config.minPrice_ = mid_ - reach;
+        config.maxPrice_ = mid_ + reach;
+        config.orderCapacity_ = 2 * levels_ * perLevel_ + 4 * Batch;
+        ob_ = std::make_unique<Orderbook>(config);
+        fills_.reserve(std::min<size_t>(levels_ * perLevel_, 1 << 16) + Batch);
+
+        bidQueues_.resize(levels_);
+        askCounts_.assign(levels_, 0);
+        for (size_t k = 0; k < perLevel_; ++k) {
+            for (size_t lvl = 0; lvl < levels_; ++lvl) {
+                AddBid(lvl, NextId());
+                ob_->AddOrder(Order{ OrderType::GoodTillCancel, NextId(), Side::Sell, AskPrice(lvl), 1 }, fills_);
+                ++askCounts_[lvl];
+            }
+        }
+    }
+
+    Orderbook &Book() { return *ob_; }
+    size_t Levels() const { return levels_; }
+    size_t PerLevel() const { return perLevel_; }
+    uint64_t Depth() const { return 2 * levels_ * perLevel_; }
+    Price BidPrice(size_t level) const { return mid_ - Gap - static_cast<Price>(level); }
+    Price AskPrice(size_t level) const { return mid_ + Gap + static_cast<Price>(level); }
+
+    OrderId NextId() { return nextId_++; }
+    size_t RandomLevel() { return std::uniform_int_distribution<size_t>(0, levels_ - 1)(rng_); }
+    std::mt19937_64 &Rng() { return rng_; }
+    Trades &Fills() { fills_.clear(); return fills_; }
+
+    // Untimed: rests a bid at the back of a level and mirrors it
+    void AddBid(size_t level, OrderId id) {
+        ob_->AddOrder(Order{ OrderType::GoodTillCancel, id, Side::Buy, BidPrice(level), BidQty }, fills_);
+        bidQueues_[level].push_back(id);
+    }
+
+    // Untimed: removes the order at `pos` from the mirror of a level (the
+    // caller cancels or moves it in the book)
+    OrderId TakeBid(size_t level, size_t pos) {
+        std::deque<OrderId> &q = bidQueues_[level];
+        OrderId id = q[pos];
+        q.erase(q.begin() + static_cast<std::ptrdiff_t>(pos));
+        return id;
+    }
+    size_t BidCount(size_t level) const { return bidQueues_[level].size(); }
+    void MirrorBid(size_t level, OrderId id) { bidQueues_[level].push_back(id); }
+
+    // Untimed: records `count` filled asks (best level first) and rests
+    // replacements at the back of the levels they came from
+    void RefillAsks(uint64_t count) {
+        for (size_t lvl = 0; count > 0 && lvl < levels_; ++lvl) {
+            size_t take = std::min<uint64_t>(count, askCounts_[lvl]);
+            askCounts_[lvl] -= take;
+            askMissing_ += take;
+            count -= take;
+        }
+        for (size_t lvl = 0; askMissing_ > 0 && lvl < levels_; ++lvl) {
+            for (; askCounts_[lvl] < perLevel_; ++askCounts_[lvl], --askMissing_)
+                ob_->AddOrder(Order{ OrderType::GoodTillCancel, NextId(), Side::Sell, AskPrice(lvl), 1 }, fills_);
+        }
+    }
+};
+
+// ---------- timing ----------
+// Accumulates fenced intervals; the empty-interval cost is subtracted per
+// interval when the case is reduced to ns/op. With counters, the group is
+// enabled just outside each interval, so the restore work is not counted.
+struct Stopwatch {
+    uint64_t ticks = 0;
+    uint64_t intervals = 0;
+    PerfCounters *counters = nullptr;
+
+    template <typename Body>
+    void Time(Body &&body) {
+        if (counters) counters->Start();
+        uint64_t start = TscClock::Start();
+        body();
+        ticks += TscClock::Stop() - start;
+        if (counters) counters->Stop();
+        ++intervals;
+    }
+};
+
+static uint64_t measure_interval_overhead() {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 10'000; ++i) {
+        uint64_t start = TscClock::Start();
+        best = std::min(best, TscClock::Stop() - start);
+    }
+    return best;
+}
+
+static volatile size_t g_sink;  // keeps read-only results alive
+
+// ---------- cases ----------
+// Each case runs `iters` operations of its kind on the fixture, timing only
+// the operations and restoring the book between batches
+struct MicroCase {
+    std::string name;
+    size_t minLevels;   // cases needing more levels than the book has are skipped
+    std::function<void(BookFixture &, uint64_t, Stopwatch &)> run;
+};
+
+template <typename Batched>
+static void in_batches(uint64_t iters, Batched &&batched) {
+    for (uint64_t done = 0; done < iters; done += Batch)
+        batched(std::min<uint64_t>(Batch, iters - done));
+}
+
+// FIFO position picked in a bid level for the cancel / modify cases
+enum class QueuePos { Front, Middle, Back, Random };
+
+static size_t pick_pos(BookFixture &fx, size_t level, QueuePos pos) {
+    size_t count = fx.BidCount(level);
+    switch (pos) {
+    case QueuePos::Front:  return 0;
+    case QueuePos::Middle: return count / 2;
+    case QueuePos::Back:   return count - 1;
+    default:               return std::uniform_int_distribution<size_t>(0, count - 1)(fx.Rng());
+    }
+}
+
+// Picks n (level, id) pairs, taking each out of the mirror so a level never
+// yields the same order twice in one batch; levels keep at least one order
+static void pick_bids(BookFixture &fx, uint64_t n, QueuePos pos,
+                      std::vector<size_t> &levels, std::vector<OrderId> &ids) {
+    levels.clear();
+    ids.clear();
+    while (ids.size() < n) {
+        size_t lvl = fx.RandomLevel();
+        if (fx.BidCount(lvl) < 2 && fx.PerLevel() > 1)
+            continue;
+        if (fx.BidCount(lvl) == 0)
+            continue;
+        levels.push_back(lvl);
+        ids.push_back(fx.TakeBid(lvl, pick_pos(fx, lvl, pos)));
+    }
+}
+
+static MicroCase add_case(const std::string &name, bool newLevel) {
+    return { name, 1, [newLevel](BookFixture &fx, uint64_t iters, Stopwatch &sw) {
+        Orderbook &ob = fx.Book();
+        std::vector<Order> orders;
+        in_batches(iters, [&](uint64_t n) {
+            orders.clear();
+            for (uint64_t k = 0; k < n; ++k) {
+                size_t lvl = newLevel ? fx.Levels() + k : fx.RandomLevel();
+                orders.push_back(Order{ OrderType::GoodTillCancel, fx.NextId(), Side::Buy, fx.BidPrice(lvl), BidQty });
+            }
+            Trades &fills = fx.Fills();
+            sw.Time([&] {
+                for (const Order &order : orders)
+                    ob.AddOrder(order, fills);
+            });
+            for (const Order &order : orders)
+                ob.CancelOrder(order.GetOrderId());
+        });
+    } };
+}
+
+static MicroCase cancel_case(const std::string &name, QueuePos pos) {
+    return { name, 1, [pos](BookFixture &fx, uint64_t iters, Stopwatch &sw) {
+        Orderbook &ob = fx.Book();
+        std::vector<size_t> levels;
+        std::vector<OrderId> ids;
+        in_batches(iters, [&](uint64_t n) {
+            pick_bids(fx, n, pos, levels, ids);
+            sw.Time([&] {
+                for (OrderId id : ids)
+                    ob.CancelOrder(id);
+            });
+            for (size_t k = 0; k < ids.size(); ++k)
+                fx.AddBid(levels[k], ids[k]);
+        });
+    } };
+}
+
+// Same-price shrink (in place) or a move to another level (cancel/replace);
+// the untimed restore puts the order back at full size on its own level
+static MicroCase modify_case(const std::string &name, bool reprice) {
+    return { name, 2, [reprice](BookFixture &fx, uint64_t iters, Stopwatch &sw) {
+        Orderbook &ob = fx.Book();
+        std::vector<size_t> levels;
+        std::vector<OrderId> ids;
+        std::vector<OrderModify> modifies;
+        in_batches(iters, [&](uint64_t n) {
+            pick_bids(fx, n, QueuePos::Random, levels, ids);
+            modifies.clear();
+            for (size_t k = 0; k < ids.size(); ++k) {
+                size_t target = levels[k];
+                while (reprice && target == levels[k])
+                    target = fx.RandomLevel();
+                modifies.emplace_back(ids[k], Side::Buy, fx.BidPrice(target), reprice ? BidQty : BidQty - 1);
+            }
+            Trades &fills = fx.Fills();
+            sw.Time([&] {
+                for (const OrderModify &modify : modifies)
+                    ob.MatchOrder(modify, fills);
+            });
+            for (size_t k = 0; k < ids.size(); ++k) {
+                ob.MatchOrder(OrderModify{ ids[k], Side::Buy, fx.BidPrice(levels[k]), BidQty }, fills);
+                fx.MirrorBid(levels[k], ids[k]);
+            }
+        });
+    } };
+}
+
+// IOC buys filling one ask each (the head of the best level)
+static MicroCase single_fill_case() {
+    return { "match_single_fill", 1, [](BookFixture &fx, uint64_t iters, Stopwatch &sw) {
+        Orderbook &ob = fx.Book();
+        std::vector<Order> orders;
+        Price limit = fx.AskPrice(fx.Levels() - 1);
+        in_batches(iters, [&](uint64_t n) {
+            orders.clear();
+            for (uint64_t k = 0; k < n; ++k)
+                orders.push_back(Order{ OrderType::ImmediateOrCancel, fx.NextId(), Side::Buy, limit, 1 });
+            Trades &fills = fx.Fills();
+            sw.Time([&] {
+                for (const Order &order : orders)
+                    ob.AddOrder(order, fills);
+            });
+            fx.RefillAsks(n);
+        });
+    } };
+}
+
+// One IOC buy consuming the `sweep` best ask levels whole; timed per op
+static MicroCase sweep_case(size_t sweep) {
+    return { "sweep_" + std::to_string(sweep) + "_levels", sweep, [sweep](BookFixture &fx, uint64_t iters, Stopwatch &sw) {
+        Orderbook &ob = fx.Book();
+        Quantity qty = static_cast<Quantity>(sweep * fx.PerLevel());
+        Price limit = fx.AskPrice(sweep - 1);
+        for (uint64_t i = 0; i < iters; ++i) {
+            Order order{ OrderType::ImmediateOrCancel, fx.NextId(), Side::Buy, limit, qty };
+            Trades &fills = fx.Fills();
+            sw.Time([&] { ob.AddOrder(order, fills); });
+            fx.RefillAsks(qty);
+        }
+    } };
+}
+
+// FOK admission: a fill of the best ask, or a reject after scanning every
+// level (one more than the side holds)
+static MicroCase fok_case(const std::string &name, bool reject) {
+    return { name, 1, [reject](BookFixture &fx, uint64_t iters, Stopwatch &sw) {
+        Orderbook &ob = fx.Book();
+        std::vector<Order> orders;
+        Price limit = fx.AskPrice(fx.Levels() - 1);
+        Quantity qty = reject ? static_cast<Quantity>(fx.Levels() * fx.PerLevel() + 1) : 1;
+        in_batches(iters, [&](uint64_t n) {
+            orders.clear();
+            for (uint64_t k = 0; k < n; ++k)
+                orders.push_back(Order{ OrderType::FillOrKill, fx.NextId(), Side::Buy, limit, qty });
+            Trades &fills = fx.Fills();
+            sw.Time([&] {
+                for (const Order &order : orders)
+                    ob.AddOrder(order, fills);
+            });
+            if (!reject)
+                fx.RefillAsks(n);
+        });
+    } };
+}
+
+static MicroCase level_infos_case() {
+    return { "get_order_infos", 1, [](BookFixture &fx, uint64_t iters, Stopwatch &sw) {
+        Orderbook &ob = fx.Book();
+        in_batches(iters, [&](uint64_t n) {
+            size_t levels = 0;
+            sw.Time([&] {
+                for (uint64_t k = 0; k < n; ++k)
+                    levels += ob.GetOrderInfos().GetBids().size();
+            });
+            g_sink = levels;
+        });
+    } };
+}
+
+static std::vector<MicroCase> all_cases() {
+    return {
+        add_case("add_new_level", true),
+        add_case("add_existing_level", false),
+        cancel_case("cancel_front", QueuePos::Front),
+        cancel_case("cancel_middle", QueuePos::Middle),
+        cancel_case("cancel_back", QueuePos::Back),
+        cancel_case("cancel_random", QueuePos::Random),
+        single_fill_case(),
+        sweep_case(8),
+        sweep_case(64),
+        fok_case("fok_fill", false),
+        fok_case("fok_reject_all_levels", true),
+        level_infos_case(),
+        modify_case("modify_resize", false),
+        modify_case("modify_reprice", true),
+    };
+}
+
+// ---------- runner ----------
+struct MicroResult {
+    std::string name;
+    uint64_t depth = 0;
+    size_t levels = 0;
+    size_t perLevel = 0;
+    uint64_t iterations = 0;   // per repetition
+    std::vector<double> samples;    // ns/op of each repetition
+    double median = 0, mean = 0, stddev = 0, cv_pct = 0, min = 0, max = 0;
+    // --counters: median events per op across repetitions (-1 unavailable)
+    std::array<double, PerfEventCount> perOp{ -1, -1, -1 };
+};
+
+static double rep_ns_per_op(const Stopwatch &sw, uint64_t iters, uint64_t overhead) {
+    uint64_t net = sw.ticks - std::min(sw.ticks, sw.intervals * overhead);
+    return static_cast<double>(net) / TscClock::Calibration().ticksPerNs_ / static_cast<double>(iters);
+}
+
+static void summarize(MicroResult &r) {
+    std::vector<double> sorted = r.samples;
+    std::sort(sorted.begin(), sorted.end());
+    size_t n = sorted.size();
+    r.median = n % 2 ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+    r.min = sorted.front();
+    r.max = sorted.back();
+    double sum = 0;
+    for (double s : sorted)
+        sum += s;
+    r.mean = sum / static_cast<double>(n);
+    double var = 0;
+    for (double s : sorted)
+        var += (s - r.mean) * (s - r.mean);
+    r.stddev = n > 1 ? std::sqrt(var / static_cast<double>(n - 1)) : 0.0;
+    r.cv_pct = r.mean > 0 ? 100.0 * r.stddev / r.mean : 0.0;
+}
+
+// Grows the iteration count until one repetition spends min_time_ms in
+// timed code (the growth runs double as warm-up), then repeats at that count
+static MicroResult run_case(const MicroCase &mc, const MicroConfig &cfg, BookFixture &fx, uint64_t overhead,
+                            PerfCounters *counters) {
+    constexpr uint64_t MaxIterations = uint64_t{ 1 } << 26;
+    const double target_ns = cfg.min_time_ms * 1e6;
+
+    uint64_t iters = 1;
+    while (true) {
+        Stopwatch sw;
+        mc.run(fx, iters, sw);
+        double elapsed = rep_ns_per_op(sw, iters, overhead) * static_cast<double>(iters);
+        if (elapsed >= target_ns || iters >= MaxIterations)
+            break;
+        double scale = elapsed > 0 ? 1.4 * target_ns / elapsed : 10.0;
+        iters = std::min(MaxIterations, static_cast<uint64_t>(std::ceil(static_cast<double>(iters) * std::clamp(scale, 2.0, 10.0))));
+    }
+
+    MicroResult r;
+    r.name = mc.name;
+    r.depth = fx.Depth();
+    r.levels = fx.Levels();
+    r.perLevel = fx.PerLevel();
+    r.iterations = iters;
+    std::array<std::vector<double>, PerfEventCount> events;
+    for (int rep = 0; rep < cfg.reps; ++rep) {
+        Stopwatch sw;
+        sw.counters = counters;
+        PerfSample before = counters ? counters->Read() : PerfSample{};
+        mc.run(fx, iters, sw);
+        r.samples.push_back(rep_ns_per_op(sw, iters, overhead));
+        if (counters) {
+            PerfSample delta = counters->Read() - before;
+            for (size_t e = 0; e < PerfEventCount; ++e)
+                events[e].push_back(static_cast<double>(delta.counts_[e]) / static_cast<double>(iters));
+        }
+    }
+    summarize(r);
+    for (size_t e = 0; counters && e < PerfEventCount; ++e) {
+        if (!counters->Available(static_cast<PerfEvent>(e)))
+            continue;
+        std::sort(events[e].begin(), events[e].end());
+        r.perOp[e] = events[e][events[e].size() / 2];
+    }
+    return r;
+}
+
+// ",l1d,llc,branch" events-per-op columns, empty when not counted
+static void write_counter_columns(std::ostream &out, const MicroResult &r) {
+    for (double v : r.perOp) {
+        out << ',';
+        if (v >= 0) out << v;
+    }
+}
+
+static void print_counters(const MicroResult &r) {
+    const char *sep = "  ";
+    for (size_t e = 0; e < PerfEventCount; ++e) {
+        if (r.perOp[e] < 0) continue;
+        std::cout << sep << PerfEventName(static_cast<PerfEvent>(e)) << '=' << std::fixed << std::setprecision(2) << r.perOp[e];
+        sep = " ";
+    }
+}
+
+// ---------- depth sweep ----------
+// Grows the book from 1k resting orders by 10x up to max_depth along one
+// axis at a time: the `levels` series adds price levels at a fixed queue
+// length, the `per_level` series lengthens the queues of a fixed set of
+// levels. Each point builds one book shared by the sweep cases (every case
+// restores it), and each case's median ns/op is fitted as c * depth^b
+// (least squares in log-log space). b near 0 is constant cost, near 1 a
+// path that scans the book.
+static const char *const SweepCases[] = { "add_existing_level", "cancel_random", "match_single_fill", "get_order_infos" };
+
+struct SweepFit {
+    double exponent = 0;
+    double r2 = 0;
+};
+
+static SweepFit fit_power_law(const std::vector<std::pair<double, double>> &points) {
+    SweepFit fit;
+    double n = static_cast<double>(points.size());
+    if (points.size() < 2)
+        return fit;
+    double sx = 0, sy = 0, sxx = 0, sxy = 0, syy = 0;
+    for (const auto &[depth, ns] : points) {
+        double x = std::log(depth), y = std::log(std::max(ns, 1e-3));
+        sx += x; sy += y; sxx += x * x; sxy += x * y; syy += y * y;
+    }
+    double vx = n * sxx - sx * sx, vy = n * syy - sy * sy, cxy = n * sxy - sx * sy;
+    fit.exponent = vx > 0 ? cxy / vx : 0.0;
+    fit.r2 = vx > 0 && vy > 0 ? cxy * cxy / (vx * vy) : 1.0;
+    return fit;
+}
+
+static const char *growth_class(double exponent) {
+    if (exponent < 0.1) return "O(1)";
+    if (exponent < 0.3) return "log-like";
+    if (exponent < 0.8) return "sub-linear";
+    return "O(N)";
+}
+
+static int run_sweep(const MicroConfig &cfg, uint64_t overhead, PerfCounters *counters) {
+    std::vector<MicroCase> cases;
+    for (MicroCase &mc : all_cases())
+        if (std::find(std::begin(SweepCases), std::end(SweepCases), mc.name) != std::end(SweepCases))
+            cases.push_back(std::move(mc));
+
+    std::ofstream points_csv(cfg.results + "depth_sweep.csv");
+    points_csv << "series,case,depth,levels,orders_per_level,iterations,median_ns,cv_pct,"
+                  "l1d_miss_per_op,llc_miss_per_op,branch_miss_per_op\n";
+    std::ofstream fit_csv(cfg.results + "depth_sweep_fit.csv");
+    fit_csv << "series,case,points,min_depth,max_depth,exponent,r2,growth,min_depth_ns,max_depth_ns\n";
+
+    for (const std::string &series : cfg.series) {
+        const bool byLevels = series == "levels";
+        if (!byLevels && series != "per_level") {
+            std::cerr << "Unknown sweep series: " << series << " (levels, per_level)\n";
+            return 1;
+        }
+        std::vector<std::vector<std::pair<double, double>>> curves(cases.size());
+        for (uint64_t depth = 1'000; depth <= cfg.max_depth; depth *= 10) {
+            size_t perSide = depth / 2;
+            BookShape shape = byLevels ? BookShape{ std::max<size_t>(1, perSide / cfg.fixed_per_level), cfg.fixed_per_level }
+                                       : BookShape{ cfg.fixed_levels, std::max<size_t>(1, perSide / cfg.fixed_levels) };
+            // pick_bids needs a batch of orders it can take without emptying levels
+            if (shape.levels * (shape.perLevel > 1 ? shape.perLevel - 1 : 1) < Batch) {
+                std::cout << "[SWEEP " << series << "] depth " << depth << " skipped (too shallow for a batch)\n";
+                continue;
+            }
+            BookFixture fx(shape, cfg.layout);
+            std::cout << "[SWEEP " << series << "] depth " << fx.Depth() << " (" << fx.Levels() << " levels x "
+                      << fx.PerLevel() << ")\n";
+            for (size_t c = 0; c < cases.size(); ++c) {
+                MicroResult r = run_case(cases[c], cfg, fx, overhead, counters);
+                std::cout << "  " << std::left << std::setw(22) << r.name << std::right << std::fixed << std::setprecision(1)
+                          << std::setw(12) << r.median << " ns  cv=" << std::setw(5) << r.cv_pct << "%";
+                print_counters(r);
+                std::cout << "\n";
+                std::cout.unsetf(std::ios::floatfield);
+                points_csv << series << ',' << r.name << ',' << r.depth << ',' << r.levels << ',' << r.perLevel << ','
+                           << r.iterations << ',' << std::fixed << std::setprecision(3) << r.median << ',' << r.cv_pct;
+                write_counter_columns(points_csv, r);
+                points_csv << '\n';
+                points_csv.unsetf(std::ios::floatfield);
+                curves[c].emplace_back(static_cast<double>(r.depth), r.median);
+            }
+        }
+        for (size_t c = 0; c < cases.size(); ++c) {
+            const auto &curve = curves[c];
+            if (curve.size() < 2)
+                continue;
+            SweepFit fit = fit_power_law(curve);
+            std::cout << "[FIT " << series << "] " << std::left << std::setw(22) << cases[c].name << std::right
+                      << std::fixed << std::setprecision(2) << " ns ~ depth^" << fit.exponent
+                      << " (R2=" << fit.r2 << ") " << growth_class(fit.exponent) << std::setprecision(1)
+                      << ": " << curve.front().second << " ns @" << static_cast<uint64_t>(curve.front().first)
+                      << " -> " << curve.back().second << " ns @" << static_cast<uint64_t>(curve.back().first) << "\n";
+            std::cout.unsetf(std::ios::floatfield);
+            fit_csv << series << ',' << cases[c].name << ',' << curve.size() << ','
+                    << static_cast<uint64_t>(curve.front().first) << ',' << static_cast<uint64_t>(curve.back().first) << ','
+                    << std::fixed << std::setprecision(4) << fit.exponent << ',' << fit.r2 << ','
+                    << growth_class(fit.exponent) << ',' << std::setprecision(3)
+                    << curve.front().second << ',' << curve.back().second << '\n';
+            fit_csv.unsetf(std::ios::floatfield);
+        }
+    }
+    std::cout << "Wrote " << cfg.results << "depth_sweep.csv and depth_sweep_fit.csv\n";
+    return 0;
+}
+
+// ---------- output ----------
+static void write_csv(const std::string &path, const std::vector<MicroResult> &results) {
+    std::ofstream f(path);
+    f << "case,depth,levels,orders_per_level,iterations,reps,median_ns,mean_ns,stddev_ns,cv_pct,min_ns,max_ns,"
+         "l1d_miss_per_op,llc_miss_per_op,branch_miss_per_op\n";
+    f << std::fixed << std::setprecision(3);
+    for (const MicroResult &r : results) {
+        f << r.name << ',' << r.depth << ',' << r.levels << ',' << r.perLevel << ','
+          << r.iterations << ',' << r.samples.size() << ','
+          << r.median << ',' << r.mean << ',' << r.stddev << ',' << r.cv_pct << ','
+          << r.min << ',' << r.max;
+        write_counter_columns(f, r);
+        f << '\n';
+    }
+}
+
+static void write_json(const std::string &path, const MicroConfig &cfg, uint64_t overhead,
+                       const std::string &counterStatus, const std::vector<MicroResult> &results) {
+    const ClockCalibration &clock = TscClock::Calibration();
+    std::ofstream f(path);
+    f << std::fixed << std::setprecision(3);
+    f << "{\n  \"context\": {\n"
+      << "    \"clock\": \"" << ClockSourceName(clock.source_) << "\",\n"
+      << "    \"ticks_per_ns\": " << clock.ticksPerNs_ << ",\n"
+      << "    \"interval_overhead_ns\": " << static_cast<double>(overhead) / clock.ticksPerNs_ << ",\n"
+      << "    \"layout\": \"" << (cfg.layout == BookLayout::Ladder ? "ladder" : "map") << "\",\n"
+      << "    \"perf_counters\": \"" << counterStatus << "\",\n"
+      << "    \"min_time_ms\": " << cfg.min_time_ms << ",\n"
+      << "    \"reps\": " << cfg.reps << "\n  },\n"
+      << "  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const MicroResult &r = results[i];
+        f << (i ? ",\n" : "\n")
+          << "    {\"name\": \"" << r.name << '/' << r.depth << "\", \"case\": \"" << r.name << "\""
+          << ", \"depth\": " << r.depth << ", \"levels\": " << r.levels << ", \"orders_per_level\": " << r.perLevel
+          << ", \"iterations\": " << r.iterations
+          << ", \"median_ns\": " << r.median << ", \"mean_ns\": " << r.mean << ", \"stddev_ns\": " << r.stddev
+          << ", \"cv_pct\": " << r.cv_pct << ", \"min_ns\": " << r.min << ", \"max_ns\": " << r.max;
+        for (size_t e = 0; e < PerfEventCount; ++e) {
+            f << ", \"" << PerfEventName(static_cast<PerfEvent>(e)) << "_per_op\": ";
+            if (r.perOp[e] >= 0) f << r.perOp[e]; else f << "null";
+        }
+        f
+          << ", \"samples_ns\": [";
+        for (size_t s = 0; s < r.samples.size(); ++s)
+            f << (s ? ", " : "") << r.samples[s];
+        f << "]}";
+    }
+    f << "\n  ]\n}\n";
+}
+
+static std::vector<uint64_t> parse_depths(const std::string &list) {
+    std::vector<uint64_t> depths;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty())
+            depths.push_back(std::max<uint64_t>(MinDepth, std::stoull(item)));
+    return depths;
+}
+
+int main(int argc, char **argv)
+{
+    MicroConfig cfg;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg.starts_with("--depths="))
+            cfg.depths = parse_depths(arg.substr(9));
+        else if (arg.starts_with("--filter="))
+            cfg.filter = arg.substr(9);
+        else if (arg.starts_with("--reps="))
+            cfg.reps = std::max(1, std::stoi(arg.substr(7)));
+        else if (arg.starts_with("--min-time-ms="))
+            cfg.min_time_ms = std::max(0.1, std::stod(arg.substr(14)));
+        else if (arg == "--book=map")
+            cfg.layout = BookLayout::Map;
+        else if (arg == "--book=ladder")
+            cfg.layout = BookLayout::Ladder;
+        else if (arg == "--clock=steady")
+            cfg.steady_clock = true;
+        else if (arg.starts_with("--out="))
+            cfg.results = arg.substr(6) + "/results/";
+        else if (arg == "--counters")
+            cfg.counters = true;
+        else if (arg == "--sweep")
+            cfg.sweep = true;
+        else if (arg.starts_with("--sweep=")) {
+            cfg.sweep = true;
+            cfg.series.clear();
+            std::stringstream ss(arg.substr(8));
+            for (std::string item; std::getline(ss, item, ',');)
+                if (!item.empty()) cfg.series.push_back(item);
+        }
+        else if (arg.starts_with("--max-depth="))
+            cfg.max_depth = std::stoull(arg.substr(12));
+        else if (arg.starts_with("--fixed-levels="))
+            cfg.fixed_levels = std::max<size_t>(1, std::stoull(arg.substr(15)));
+        else if (arg.starts_with("--fixed-per-level="))
+            cfg.fixed_per_level = std::max<size_t>(1, std::stoull(arg.substr(18)));
+    }
+
+    std::filesystem::create_directories(cfg.results);
+
+    const ClockCalibration &clock = TscClock::Calibrate(std::chrono::milliseconds{ 50 }, !cfg.steady_clock);
+    const uint64_t overhead = measure_interval_overhead();
+    std::cout << "[CLOCK] " << ClockSourceName(clock.source_)
+              << " ticks/ns=" << clock.ticksPerNs_
+              << " interval_overhead=" << static_cast<double>(overhead) / clock.ticksPerNs_ << " ns\n";
+
+    // Only a group that opened is passed on; otherwise timings only
+    std::unique_ptr<PerfCounters> counters;
+    std::string counterStatus = "off";
+    if (cfg.counters) {
+        counters = std::make_unique<PerfCounters>();
+        counterStatus = counters->Status();
+        std::cout << "[COUNTERS] " << counterStatus << "\n";
+        if (!counters->Available())
+            counters.reset();
+    }
+
+    if (cfg.sweep)
+        return run_sweep(cfg, overhead, counters.get());
+
+    std::vector<MicroResult> results;
+    for (const MicroCase &mc : all_cases()) {
+        if (!cfg.filter.empty() && mc.name.find(cfg.filter) == std::string::npos)
+            continue;
+        for (uint64_t depth : cfg.depths) {
+            // fresh book per case so earlier cases leave no residue
+            BookFixture fx(shape_for_depth(depth), cfg.layout);
+            if (fx.Levels() < mc.minLevels) {
+                std::cout << std::left << std::setw(24) << mc.name << std::setw(10) << fx.Depth()
+                          << "skipped (" << fx.Levels() << " levels)\n";
+                continue;
+            }
+            MicroResult r = run_case(mc, cfg, fx, overhead, counters.get());
+            std::cout << std::left << std::setw(24) << r.name << std::setw(10) << r.depth << std::right
+                      << " iters=" << std::setw(9) << r.iterations
+                      << std::fixed << std::setprecision(1)
+                      << "  median=" << std::setw(10) << r.median << " ns"
+                      << "  cv=" << std::setw(5) << r.cv_pct << "%"
+                      << "  [" << r.min << ", " << r.max << "]"
+                      << (r.cv_pct > 5.0 ? "  (noisy)" : "");
+            print_counters(r);
+            std::cout << "\n";
+            std::cout.unsetf(std::ios::floatfield);
+            results.push_back(std::move(r));
+        }
+    }
+
+    write_csv(cfg.results + "microbench.csv", results);
+    write_json(cfg.results + "microbench.json", cfg, overhead, counterStatus, results);
+    std::cout << "Wrote " << cfg.results << "microbench.csv and microbench.json\n";
+    return 0;
+}
@@ -5,14 +5,50 @@
 // - Market order sweep behavior
 // - IOC / FOK semantics
 // - Partial fills and empty-book behavior
+// - FIFO order within a level after cancels (pooled order slots)
+// - Open-addressing order-id index (growth, find-and-erase, probe length)
+// - Cached per-level quantity / order count
+// - Incremental top of book (best price and quantity)
+// - Caller-supplied trade buffer (sink overloads)
+// - Price-ladder book layout (bitmap level search, band limits)
+// - Matching thread front end (SPSC ingress / outbound rings, event reports, rejects)
+// - Multi-symbol engine routing across shards
+// - Binary event journal (buffer rotation, background flush, CSV decode)
+// - Full-state snapshot / restore (FIFO position, counters, event seq)
+// - Binary op trace conversion (round trip, out-of-range fields)
+// - Write-ahead command log (group commit, torn tail, recovery replay, rejects)
+// - Batched command processing (same fills and events as single calls)
+// - In-place modify (quantity reduction keeps time priority)
+// - Log-linear latency histogram (bucket precision, percentiles, merge)
+// - Calibrated TSC clock (fallback, tick-to-ns conversion)
 //
 // This file is NOT part of benchmark or production runs.
 // It is used prior to deterministic replay and performance testing.
+//
+// Every check is an assert, so they must stay compiled in even when the
+// rest of the build defines NDEBUG.
+#undef NDEBUG
 
 
 #include "Orderbook.h"
 #include "Order.h"
+#include "MatchingThread.h"
+#include "MatchingEngine.h"
+#include "EventJournal.h"
+#include "CommandLog.h"
+#include "BinaryTrace.h"
+#include "LatencyHistogram.h"
+#include "TscClock.h"
 #include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
 #include <iostream>
 
 static void test_market_buy_sweeps_asks();
@@ -162,6 +198,938 @@ void test_gtc_resting_after_market() {
     assert(ob.Size() == 1);
 }
 
+void test_cancel_middle_keeps_fifo() {
+    Orderbook ob;
+
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 1, Side::Sell, 100, 5));
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 2, Side::Sell, 100, 5));
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 3, Side::Sell, 100, 5));
+    ob.CancelOrder(2);
+
+    // freed slot is reused by the next order, which must queue behind 3
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 4, Side::Sell, 100, 5));
+
+    auto trades = ob.AddOrder(Order(OrderType::GoodTillCancel, 10, Side::Buy, 100, 12));
+    assert(trades.size() == 3);
+    assert(trades[0].GetAskTrade().orderId_ == 1);
+    assert(trades[1].GetAskTrade().orderId_ == 3);
+    assert(trades[2].GetAskTrade().orderId_ == 4);
+    assert(trades[2].GetAskTrade().quantity_ == 2);
+    assert(ob.Size() == 1);
+}
+
+void test_level_aggregates() {
+    Orderbook ob;
+
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 1, Side::Sell, 100, 10));
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 2, Side::Sell, 100, 7));
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 3, Side::Sell, 101, 4));
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 4, Side::Buy, 100, 12));   // fills 1, partially 2
+    ob.CancelOrder(3);
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 5, Side::Sell, 100, 6));
+
+    auto infos = ob.GetOrderInfos();
+    assert(infos.GetBids().empty());
+    assert(infos.GetAsks().size() == 1);
+    assert(infos.GetAsks()[0].price_ == 100);
+    assert(infos.GetAsks()[0].quantity_ == 11);
+    assert(infos.GetAsks()[0].orderCount_ == 2);
+
+    // FOK admission uses the cached level quantity
+    auto rejected = ob.AddOrder(Order(OrderType::FillOrKill, 6, Side::Buy, 100, 12));
+    auto filled = ob.AddOrder(Order(OrderType::FillOrKill, 7, Side::Buy, 100, 11));
+    assert(rejected.empty());
+    assert(total_qty(filled) == 11);
+    assert(ob.Size() == 0);
+}
+
+void test_top_of_book_incremental() {
+    Orderbook ob;
+
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 1, Side::Buy, 99, 4));
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 2, Side::Buy, 100, 6));
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 3, Side::Buy, 100, 2));
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 4, Side::Sell, 105, 3));
+    assert(ob.GetBestBidPrice() == 100 && ob.GetBestBidQuantity() == 8);
+    assert(ob.GetBestAskPrice() == 105 && ob.GetBestAskQuantity() == 3);
+
+    // worse-priced add and cancel leave the touch alone
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 5, Side::Buy, 98, 1));
+    ob.CancelOrder(1);
+    assert(ob.GetBestBidPrice() == 100 && ob.GetBestBidQuantity() == 8);
+
+    // partial fill of the best level updates quantity only
+    ob.AddOrder(Order(OrderType::ImmediateOrCancel, 6, Side::Sell, 100, 7));
+    assert(ob.GetBestBidPrice() == 100 && ob.GetBestBidQuantity() == 1);
+
+    // emptying the best level falls back to the next one
+    ob.CancelOrder(3);
+    assert(ob.GetBestBidPrice() == 98 && ob.GetBestBidQuantity() == 1);
+
+    ob.AddOrder(Order(OrderType::Market, 7, Side::Buy, 0, 3));
+    assert(ob.GetBestAskPrice() == 0 && ob.GetBestAskQuantity() == 0);
+    assert(ob.GetBestBidPrice() == 98);
+}
+
+void test_trade_sink_appends() {
+    Orderbook ob;
+    Trades fills;
+
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 1, Side::Sell, 100, 5), fills);
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 2, Side::Sell, 101, 5), fills);
+    assert(fills.empty());
+
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 3, Side::Buy, 100, 3), fills);
+    ob.MatchOrder(OrderModify(3, Side::Buy, 101, 8), fills);   // 3 is fully filled: no-op
+    assert(fills.size() == 1);
+    assert(fills[0].GetAskTrade().orderId_ == 1 && fills[0].GetAskTrade().quantity_ == 3);
+
+    ob.AddOrder(Order(OrderType::Market, 4, Side::Buy, 0, 6), fills);
+    assert(fills.size() == 3);      // appended, not overwritten
+    assert(fills[1].GetAskTrade().orderId_ == 1 && fills[1].GetAskTrade().quantity_ == 2);
+    assert(fills[2].GetAskTrade().orderId_ == 2 && fills[2].GetAskTrade().quantity_ == 4);
+    assert(ob.Size() == 1);
+}
+
+void test_order_index_grow_and_extract() {
+    OrderIndex index(4);
+
+    // strided ids collide in the low bits and force several rehashes
+    for (OrderId i = 0; i < 5000; ++i) {
+        bool inserted = index.Insert(i * 1024, static_cast<OrderHandle>(i));
+        assert(inserted);
+    }
+    bool duplicate = index.Insert(0, 99);
+    assert(!duplicate && index.Size() == 5000);
+
+    for (OrderId i = 0; i < 5000; i += 2) {
+        OrderHandle extracted = index.Extract(i * 1024);
+        assert(extracted == static_cast<OrderHandle>(i));
+    }
+    OrderHandle missing = index.Extract(0);
+    assert(missing == InvalidOrderHandle);
+
+    for (OrderId i = 0; i < 5000; ++i) {
+        OrderHandle expected = (i % 2) ? static_cast<OrderHandle>(i) : InvalidOrderHandle;
+        assert(index.Find(i * 1024) == expected);
+    }
+    assert(index.Size() == 2500);
+
+    // Two dense id ranges far apart resting together (warmup ids 10..,
+    // bulk ids 1'000'000..) must not wrap onto each other's slots and
+    // merge into one long probe cluster, whether the index grew or was sized
+    for (size_t capacity : { size_t{ 0 }, size_t{ 1 } << 17 }) {
+        OrderIndex dense(capacity);
+        OrderHandle handle = 0;
+        for (OrderId id = 10; id < 10 + 50'000; ++id)
+            dense.Insert(id, handle++);
+        for (OrderId id = 1'000'000; id < 1'000'000 + 50'000; ++id)
+            dense.Insert(id, handle++);
+        assert(dense.Size() == 100'000);
+        assert(dense.MaxProbeLength() <= 64);
+        assert(dense.Find(10) == 0 && dense.Find(1'000'000) == 50'000);
+    }
+}
+
+static OrderbookConfig ladder_config(Price minPrice, Price maxPrice) {
+    OrderbookConfig config;
+    config.layout_ = BookLayout::Ladder;
+    config.minPrice_ = minPrice;
+    config.maxPrice_ = maxPrice;
+    return config;
+}
+
+void test_ladder_sweep_across_words() {
+    Orderbook ob(ladder_config(1, 1000));
+
+    // levels far apart so next-level search crosses several bitmap words
+    ob.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Sell, 500, 10));
+    ob.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Sell, 700, 10));
+    ob.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Sell, 999, 10));
+    ob.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 4, Side::Buy, 300, 3));
+    ob.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 5, Side::Buy, 2, 3));
+
+    assert(ob.GetBestAskPrice() == 500);
+    assert(ob.GetBestBidPrice() == 300);
+
+    auto trades = ob.AddOrder(std::make_shared<Order>(OrderType::Market, 10, Side::Buy, 0, 15));
+    assert(trades.size() == 2);
+    assert(trades[0].GetAskTrade().price_ == 500);
+    assert(trades[1].GetAskTrade().price_ == 700);
+    assert(total_qty(trades) == 15);
+    assert(ob.GetBestAskPrice() == 700);
+
+    ob.AddOrder(std::make_shared<Order>(OrderType::Market, 11, Side::Sell, 0, 4));
+    assert(ob.GetBestBidPrice() == 2);
+
+    auto infos = ob.GetOrderInfos();
+    assert(infos.GetAsks().size() == 2 && infos.GetAsks()[0].quantity_ == 5);
+    assert(infos.GetBids().size() == 1 && infos.GetBids()[0].quantity_ == 2);
+}
+
+void test_ladder_cancel_moves_best() {
+    Orderbook ob(ladder_config(100, 200));
+
+    ob.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Buy, 150, 5));
+    ob.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 2, Side::Buy, 120, 5));
+    ob.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 3, Side::Buy, 100, 5));
+
+    ob.CancelOrder(1);
+    assert(ob.GetBestBidPrice() == 120);
+    ob.CancelOrder(2);
+    assert(ob.GetBestBidPrice() == 100);
+    ob.CancelOrder(3);
+    assert(ob.GetBestBidPrice() == 0);
+    assert(ob.Size() == 0);
+}
+
+void test_ladder_rejects_out_of_band() {
+    Orderbook ob(ladder_config(100, 200));
+
+    bool threw = false;
+    try {
+        ob.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Sell, 201, 5));
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(ob.Size() == 0);
+}
+
+void test_ladder_rejects_out_of_band_modify() {
+    Orderbook ob(ladder_config(100, 200));
+    std::vector<Event> events;
+    ob.SetObserver([&events](const Event& e) { events.push_back(e); });
+    ob.EnableEvents(true);
+    ob.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, 1, Side::Sell, 150, 5));
+    std::size_t eventsBefore = events.size();
+
+    bool threw = false;
+    try {
+        ob.MatchOrder(OrderModify(1, Side::Sell, 250, 5));
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    assert(threw);
+    // The resting order survives and no MODIFY/CANCEL was emitted
+    assert(ob.Size() == 1);
+    assert(events.size() == eventsBefore);
+    auto infos = ob.GetOrderInfos();
+    assert(infos.GetAsks().size() == 1);
+    assert(infos.GetAsks()[0].price_ == 150 && infos.GetAsks()[0].quantity_ == 5);
+
+    // An in-band reprice still goes through
+    ob.MatchOrder(OrderModify(1, Side::Sell, 120, 5));
+    assert(ob.Size() == 1);
+    assert(ob.GetOrderInfos().GetAsks()[0].price_ == 120);
+}
+
+void test_matching_thread_round_trip() {
+    MatchingThreadConfig config;
+    config.inboundCapacity_ = 4;    // small rings force wrap-around and backpressure
+    config.outboundCapacity_ = 4;
+    MatchingThread engine(config);
+    engine.AddSymbol(0);
+    engine.Start();
+
+    auto cmd = [](CommandType type, OrderId id, Side side, Price price, Quantity qty, uint64_t tag) {
+        Command c;
+        c.type_ = type; c.orderId_ = id; c.side_ = side; c.price_ = price; c.quantity_ = qty; c.tag_ = tag;
+        return c;
+    };
+    std::vector<Command> commands = {
+        cmd(CommandType::Add, 1, Side::Sell, 100, 5, 10),
+        cmd(CommandType::Add, 2, Side::Sell, 101, 5, 11),
+        cmd(CommandType::Add, 3, Side::Sell, 102, 5, 12),
+        cmd(CommandType::Cancel, 2, Side::Sell, 0, 0, 13),
+        cmd(CommandType::Add, 4, Side::Buy, 102, 8, 14),   // fills 1 (5) then 3 (3)
+    };
+
+    std::vector<ExecutionReport> reports;
+    size_t next = 0, done = 0;
+    while (done < commands.size()) {
+        if (next < commands.size() && engine.TrySubmit(commands[next]))
+            ++next;
+        ExecutionReport r;
+        while (engine.TryPoll(r)) {
+            reports.push_back(r);
+            done += (r.type_ == ReportType::Done);
+        }
+    }
+    engine.Stop();
+
+    // Reports arrive in command order; fills precede their command's Done
+    assert(reports.size() == commands.size() + 2);
+    for (size_t i = 0; i < 4; ++i) {
+        assert(reports[i].type_ == ReportType::Done);
+        assert(reports[i].tag_ == 10 + i);
+    }
+    assert(reports[4].type_ == ReportType::Fill && reports[4].ask_.orderId_ == 1 && reports[4].ask_.quantity_ == 5);
+    assert(reports[5].type_ == ReportType::Fill && reports[5].ask_.orderId_ == 3 && reports[5].ask_.quantity_ == 3);
+    assert(reports[4].tag_ == 14 && reports[5].bid_.orderId_ == 4);
+    assert(reports[6].type_ == ReportType::Done && reports[6].fillCount_ == 2);
+
+    assert(engine.GetBook(0).Size() == 1);
+    assert(engine.GetBook(0).GetBestAskPrice() == 102);
+    assert(engine.GetBook(0).GetBestAskQuantity() == 2);
+}
+
+void test_matching_thread_rejects_book_errors() {
+    MatchingThreadConfig config;
+    config.book_ = ladder_config(100, 200);
+    MatchingThread engine(config);
+    engine.AddSymbol(0);
+    engine.Start();
+
+    auto cmd = [](CommandType type, OrderId id, Price price, uint64_t tag) {
+        Command c;
+        c.type_ = type; c.orderId_ = id; c.side_ = Side::Sell; c.price_ = price; c.quantity_ = 5; c.tag_ = tag;
+        return c;
+    };
+    Command unknown = cmd(CommandType::Add, 4, 150, 13);
+    unknown.symbol_ = 7;
+    std::vector<Command> commands = {
+        cmd(CommandType::Add, 1, 150, 10),
+        cmd(CommandType::Add, 2, 250, 11),      // outside the band
+        cmd(CommandType::Modify, 1, 250, 12),   // reprice outside the band
+        unknown,
+        cmd(CommandType::Add, 3, 160, 14),      // the thread is still running
+    };
+
+    std::vector<ExecutionReport> reports;
+    size_t next = 0, done = 0;
+    while (done < commands.size()) {
+        if (next < commands.size() && engine.TrySubmit(commands[next]))
+            ++next;
+        ExecutionReport r;
+        while (engine.TryPoll(r)) {
+            reports.push_back(r);
+            done += (r.type_ == ReportType::Done);
+        }
+    }
+    engine.Stop();
+
+    // Each refused command gets a Reject followed by its Done
+    std::vector<std::pair<ReportType, uint64_t>> expected = {
+        {ReportType::Done, 10},
+        {ReportType::Reject, 11}, {ReportType::Done, 11},
+        {ReportType::Reject, 12}, {ReportType::Done, 12},
+        {ReportType::Reject, 13}, {ReportType::Done, 13},
+        {ReportType::Done, 14},
+    };
+    assert(reports.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+        assert(reports[i].type_ == expected[i].first && reports[i].tag_ == expected[i].second);
+
+    assert(engine.GetBook(0).Size() == 2);
+    assert(engine.GetBook(0).GetBestAskPrice() == 150);
+}
+
+void test_matching_thread_publishes_events() {
+    MatchingThreadConfig config;
+    config.events_ = true;
+    config.outboundCapacity_ = 4;
+    MatchingThread engine(config);
+    engine.AddSymbol(0);
+    engine.Start();
+
+    auto cmd = [](CommandType type, OrderId id, Side side, Price price, Quantity qty) {
+        Command c;
+        c.type_ = type; c.orderId_ = id; c.side_ = side; c.price_ = price; c.quantity_ = qty; c.tag_ = id;
+        return c;
+    };
+    std::vector<Command> commands = {
+        cmd(CommandType::Add, 1, Side::Sell, 100, 5),
+        cmd(CommandType::Add, 2, Side::Sell, 101, 5),
+        cmd(CommandType::Modify, 2, Side::Sell, 102, 5),
+        cmd(CommandType::Add, 3, Side::Buy, 102, 8),    // fills 1 (5) then 2 (3)
+        cmd(CommandType::Cancel, 2, Side::Sell, 0, 0),
+    };
+
+    // The same commands on a plain book give the expected event stream
+    Orderbook reference;
+    std::vector<Event> expected;
+    reference.SetObserver([&](const Event& e) { expected.push_back(e); });
+    reference.EnableEvents(true);
+    for (const Command& c : commands) {
+        if (c.type_ == CommandType::Add)
+            reference.AddOrder(Order(c.orderType_, c.orderId_, c.side_, c.price_, c.quantity_));
+        else if (c.type_ == CommandType::Cancel)
+            reference.CancelOrder(c.orderId_);
+        else
+            reference.MatchOrder(OrderModify(c.orderId_, c.side_, c.price_, c.quantity_));
+    }
+
+    std::vector<ExecutionReport> events;
+    size_t next = 0, done = 0, fills = 0;
+    while (done < commands.size()) {
+        if (next < commands.size() && engine.TrySubmit(commands[next]))
+            ++next;
+        ExecutionReport r;
+        while (engine.TryPoll(r)) {
+            if (r.type_ == ReportType::Event) {
+                // a command's events come before its fills and Done
+                assert(r.tag_ == commands[done].tag_ && fills == 0);
+                events.push_back(r);
+            }
+            fills += (r.type_ == ReportType::Fill);
+            if (r.type_ == ReportType::Done) {
+                ++done;
+                fills = 0;
+            }
+        }
+    }
+    engine.Stop();
+
+    assert(!expected.empty() && events.size() == expected.size());
+    for (size_t i = 0; i < events.size(); ++i) {
+        const Event& e = events[i].event_;
+        assert(e.seq == expected[i].seq && e.type == expected[i].type);
+        assert(e.order_id == expected[i].order_id && e.order_id2 == expected[i].order_id2);
+        assert(e.price == expected[i].price && e.qty == expected[i].qty && e.side == expected[i].side);
+    }
+}
+
+void test_matching_engine_routes_symbols() {
+    MatchingEngineConfig config;
+    config.shardCount_ = 2;
+    MatchingEngine engine(config);
+    engine.AddSymbol(7);    // shard 0
+    engine.AddSymbol(3);    // shard 1
+    engine.AddSymbol(5);    // shard 0
+    assert(engine.ShardOf(7) == 0 && engine.ShardOf(3) == 1 && engine.ShardOf(5) == 0);
+    engine.Start();
+
+    // Same order ids and prices on every symbol: books must stay independent
+    std::vector<Command> commands;
+    for (SymbolId sym : {7u, 3u, 5u}) {
+        Command ask; ask.symbol_ = sym; ask.orderId_ = 1; ask.side_ = Side::Sell; ask.price_ = 100; ask.quantity_ = 10;
+        commands.push_back(ask);
+    }
+    Command bid; bid.symbol_ = 3; bid.orderId_ = 2; bid.side_ = Side::Buy; bid.price_ = 100; bid.quantity_ = 4;
+    commands.push_back(bid);
+
+    size_t done = 0, fills = 0;
+    for (const auto& c : commands)
+        while (!engine.TrySubmit(c)) {}
+    while (done < commands.size()) {
+        ExecutionReport r;
+        if (!engine.TryPoll(r)) continue;
+        if (r.type_ == ReportType::Fill) { ++fills; assert(r.symbol_ == 3); }
+        if (r.type_ == ReportType::Done) ++done;
+    }
+    engine.Stop();
+
+    assert(fills == 1);
+    assert(engine.GetBook(3).GetBestAskQuantity() == 6);
+    assert(engine.GetBook(7).GetBestAskQuantity() == 10);
+    assert(engine.GetBook(5).GetBestAskQuantity() == 10);
+
+    bool threw = false;
+    try {
+        Command unknown; unknown.symbol_ = 4;
+        engine.TrySubmit(unknown);
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+void test_event_journal_matches_observer() {
+    const char* path = "ob_correctness_journal.bin";
+    const char* csvPath = "ob_correctness_journal.csv";
+
+    for (bool background : {false, true}) {
+        std::vector<std::string> expected;
+        Orderbook reference;
+        reference.SetObserver([&expected](const Event& e) { expected.push_back(e.to_csv()); });
+        reference.EnableEvents(true);
+
+        EventJournal journal;
+        journal.Open(path, 3, background);     // tiny buffer: many rotations
+        JournaledOrderbook ob(OrderbookConfig{}, JournalEventListener{&journal});
+
+        auto run = [](auto& b) {
+            b.AddOrder(Order(OrderType::GoodTillCancel, 1, Side::Sell, 100, 5));
+            b.AddOrder(Order(OrderType::GoodTillCancel, 2, Side::Sell, 101, 5));
+            b.AddOrder(Order(OrderType::GoodTillCancel, 3, Side::Buy, 99, 4));
+            b.MatchOrder(OrderModify(3, Side::Buy, 100, 7));
+            b.AddOrder(Order(OrderType::Market, 4, Side::Buy, 0, 4));
+            b.CancelOrder(2);
+        };
+        run(reference);
+        run(ob);
+        journal.Close();
+        assert(journal.RecordCount() == expected.size());
+
+        uint64_t decoded = DecodeEventJournalToCsv(path, csvPath);
+        assert(decoded == expected.size());
+        std::ifstream in(csvPath);
+        std::string line;
+        std::getline(in, line);     // column header
+        std::vector<std::string> lines;
+        while (std::getline(in, line))
+            lines.push_back(line);
+        assert(lines == expected);
+    }
+    std::remove(path);
+    std::remove(csvPath);
+}
+
+void test_snapshot_restore_preserves_state() {
+    const char* path = "ob_correctness_snapshot.bin";
+
+    Orderbook original;
+    original.EnableEvents(true);
+    original.AddOrder(Order(OrderType::GoodTillCancel, 1, Side::Sell, 101, 5));
+    original.AddOrder(Order(OrderType::GoodTillCancel, 2, Side::Sell, 101, 7));
+    original.AddOrder(Order(OrderType::GoodTillCancel, 3, Side::Sell, 103, 4));
+    original.AddOrder(Order(OrderType::GoodTillCancel, 4, Side::Buy, 99, 6));
+    original.AddOrder(Order(OrderType::GoodTillCancel, 5, Side::Buy, 98, 2));
+    original.AddOrder(Order(OrderType::GoodTillCancel, 6, Side::Buy, 99, 3));
+    original.AddOrder(Order(OrderType::ImmediateOrCancel, 7, Side::Buy, 101, 2));  // partially fills 1
+    original.MatchOrder(OrderModify(5, Side::Buy, 98, 0));  // cancel/replace rests 5 with qty 0
+    assert(original.Size() == 6);
+    original.SaveSnapshot(path);
+
+    Orderbook restored;
+    restored.EnableEvents(true);
+    restored.LoadSnapshot(path);
+    std::remove(path);
+
+    assert(restored.Size() == original.Size());
+    assert(restored.GetMatchedOrders() == original.GetMatchedOrders());
+    assert(restored.GetEventSeq() == original.GetEventSeq());
+    assert(restored.GetBestBidPrice() == 99 && restored.GetBestAskPrice() == 101);
+    assert(restored.GetBestAskQuantity() == original.GetBestAskQuantity());
+    auto zeroLevel = restored.GetOrderInfos().GetBids();
+    assert(zeroLevel.size() == 2 && zeroLevel[1].price_ == 98 && zeroLevel[1].quantity_ == 0);
+
+    auto a = original.GetOrderInfos(), b = restored.GetOrderInfos();
+    assert(a.GetBids().size() == b.GetBids().size() && a.GetAsks().size() == b.GetAsks().size());
+    for (size_t i = 0; i < a.GetBids().size(); ++i)
+        assert(a.GetBids()[i].price_ == b.GetBids()[i].price_ && a.GetBids()[i].quantity_ == b.GetBids()[i].quantity_);
+    for (size_t i = 0; i < a.GetAsks().size(); ++i)
+        assert(a.GetAsks()[i].price_ == b.GetAsks()[i].price_ && a.GetAsks()[i].quantity_ == b.GetAsks()[i].quantity_);
+
+    // Same sweep on both books: identical fills in identical FIFO order
+    auto ta = original.AddOrder(Order(OrderType::Market, 8, Side::Buy, 0, 12));
+    auto tb = restored.AddOrder(Order(OrderType::Market, 8, Side::Buy, 0, 12));
+    assert(ta.size() == 3 && tb.size() == ta.size());
+    for (size_t i = 0; i < ta.size(); ++i) {
+        assert(ta[i].GetAskTrade().orderId_ == tb[i].GetAskTrade().orderId_);
+        assert(ta[i].GetAskTrade().quantity_ == tb[i].GetAskTrade().quantity_);
+    }
+    assert(tb[0].GetAskTrade().orderId_ == 1 && tb[0].GetAskTrade().quantity_ == 3);
+    assert(original.GetEventSeq() == restored.GetEventSeq());
+
+    // Loading into a non-empty book is refused
+    original.SaveSnapshot(path);
+    bool threw = false;
+    try {
+        restored.LoadSnapshot(path);
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    std::remove(path);
+    assert(threw);
+}
+
+void test_trace_conversion_checks_ranges() {
+    const char* csvPath = "ob_correctness_trace.csv";
+    const char* binPath = "ob_correctness_trace.bin";
+    auto convert = [&](const std::string& body) {
+        std::ofstream(csvPath) << "# seed=7,scenario=ranges\n" << body;
+        try {
+            return static_cast<long long>(ConvertTraceCsvToBinary(csvPath, binPath));
+        } catch (const std::runtime_error&) {
+            return -1LL;
+        }
+    };
+
+    long long converted = convert("ADD,4294967295,1,0,100,5\nMODIFY,4294967295,1,101,3\nCANCEL,4294967295\nMATCH\n");
+    assert(converted == 4);
+    {
+        MappedTrace trace(binPath);
+        assert(trace.Records().size() == 4 && trace.Records()[0].orderId_ == 4294967295u);
+        assert(static_cast<Side>(trace.Records()[1].side_) == Side::Sell);
+    }
+
+    // Values the 16-byte record cannot hold are refused, not truncated
+    const char* rejected[] = {
+        "ADD,4294967296,1,0,100,5\n",      // id needs 33 bits
+        "CANCEL,-1\n",
+        "ADD,1,4,0,100,5\n",               // no such order type
+        "ADD,1,1,2,100,5\n",               // no such side
+        "MODIFY,1,0,100,4294967296\n",     // quantity
+        "ADD,1,1,0,10x,5\n",
+    };
+    for (const char* body : rejected) {
+        converted = convert(body);
+        assert(converted == -1);
+    }
+    std::remove(csvPath);
+    std::remove(binPath);
+}
+
+void test_command_log_group_commit_and_recover() {
+    const char* path = "ob_correctness_commands.log";
+
+    Orderbook live;
+    live.EnableEvents(true);
+    CommandLog log;
+    CommandLogConfig config;
+    config.groupCommitCount_ = 3;
+    config.groupCommitInterval_ = std::chrono::hours(1);
+    log.Open(path, config);
+    WriteAheadBook<Orderbook> wal(live, log);
+
+    auto add = [](OrderId id, Side side, Price price, Quantity qty) {
+        Command c;
+        c.type_ = CommandType::Add;
+        c.orderId_ = id;
+        c.side_ = side;
+        c.price_ = price;
+        c.quantity_ = qty;
+        return c;
+    };
+    Command cancel;
+    cancel.type_ = CommandType::Cancel;
+    cancel.orderId_ = 2;
+    Command modify;
+    modify.type_ = CommandType::Modify;
+    modify.orderId_ = 3;
+    modify.side_ = Side::Buy;
+    modify.price_ = 101;
+    modify.quantity_ = 4;
+
+    Trades trades;
+    uint64_t firstLsn = wal.Apply(add(1, Side::Sell, 101, 5), trades);
+    assert(firstLsn == 1);
+    wal.Apply(add(2, Side::Sell, 102, 5), trades);
+    assert(log.DurableLsn() == 0);                  // group not full yet
+    uint64_t seqBefore = live.GetEventSeq();
+    wal.Apply(add(3, Side::Buy, 99, 2), trades);
+    assert(log.DurableLsn() == 3 && log.CommitCount() == 1);
+    wal.Apply(cancel, trades);
+    trades.clear();
+    wal.Apply(modify, trades);                      // crosses order 1
+    assert(trades.size() == 1);
+    assert(log.DurableLsn() == 3 && log.LastLsn() == 5);
+    log.Commit();
+    assert(log.DurableLsn() == 5 && log.CommitCount() == 2);
+    log.Close();
+
+    // Record 3 carries the event seq the book was at when it was applied
+    {
+        CommandLogReader reader(path);
+        CommandLogRecord r;
+        int read = 0;
+        while (read < 3 && reader.Next(r))
+            ++read;
+        assert(read == 3 && r.lsn_ == 3 && r.eventSeq_ == seqBefore);
+    }
+
+    // A crash mid-group leaves a torn tail: partial, zero-filled or garbled
+    // records after the last good one. Recovery stops there.
+    std::string logBytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        logBytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    const size_t recordSize = sizeof(CommandLogRecord);
+    assert(logBytes.size() == sizeof(CommandLogHeader) + 5 * recordSize);
+    std::string last = logBytes.substr(logBytes.size() - recordSize);
+    std::string nextLsn = last;      // lsn 6 but the CRC still covers lsn 5
+    nextLsn[0] = 6;
+    std::string flipped = last;      // lsn 5 again, one field bit flipped
+    flipped[offsetof(CommandLogRecord, price_)] ^= 1;
+
+    const std::string tails[] = {
+        "torn",
+        std::string(2 * recordSize, '\0'),
+        nextLsn + last,
+        last,                           // valid CRC, but lsn 5 repeats
+        flipped,
+        last.substr(0, recordSize / 2),
+    };
+    Trades replayed;
+    for (const std::string& tail : tails) {
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out << logBytes << tail;
+        }
+        Orderbook recovered;
+        recovered.EnableEvents(true);
+        uint64_t recoveredCount = RecoverCommandLog(recovered, path, replayed);
+        CommandLogReader reader(path);
+        CommandLogRecord r;
+        while (reader.Next(r)) {}
+        assert(recoveredCount == 5 && reader.TornTail());
+        assert(recovered.Size() == live.Size());
+        assert(recovered.GetEventSeq() == live.GetEventSeq());
+        assert(recovered.GetMatchedOrders() == live.GetMatchedOrders());
+        assert(recovered.GetBestBidPrice() == live.GetBestBidPrice());
+        assert(recovered.GetBestAskPrice() == live.GetBestAskPrice());
+        assert(recovered.GetBestBidQuantity() == live.GetBestBidQuantity());
+    }
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << logBytes;
+        out.close();
+        CommandLogReader reader(path);
+        CommandLogRecord r;
+        while (reader.Next(r)) {}
+        assert(!reader.TornTail());
+    }
+
+    // A book whose event sequence diverges from the log is refused
+    Orderbook silent;
+    bool threw = false;
+    try {
+        RecoverCommandLog(silent, path, replayed);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    std::remove(path);
+    assert(threw);
+}
+
+void test_command_log_recovers_past_rejected_command() {
+    const char* path = "ob_correctness_commands_reject.log";
+
+    // A command the ladder book refuses is still logged; recovery must
+    // refuse it again and carry on with the commands after it
+    Orderbook live(ladder_config(1, 100));
+    live.EnableEvents(true);
+    CommandLog log;
+    log.Open(path);
+    WriteAheadBook<Orderbook> wal(live, log);
+
+    auto add = [](OrderId id, Side side, Price price, Quantity qty) {
+        Command c;
+        c.type_ = CommandType::Add;
+        c.orderId_ = id;
+        c.side_ = side;
+        c.price_ = price;
+        c.quantity_ = qty;
+        return c;
+    };
+    Command modify;
+    modify.type_ = CommandType::Modify;
+    modify.orderId_ = 1;
+    modify.side_ = Side::Buy;
+    modify.price_ = 250;
+    modify.quantity_ = 5;
+
+    Trades trades;
+    wal.Apply(add(1, Side::Buy, 50, 5), trades);
+    int rejected = 0;
+    for (const Command& c : { add(2, Side::Buy, 500, 5), modify }) {
+        try {
+            wal.Apply(c, trades);
+        } catch (const std::logic_error&) {
+            ++rejected;
+        }
+    }
+    wal.Apply(add(3, Side::Sell, 60, 5), trades);
+    wal.Apply(add(4, Side::Sell, 50, 2), trades);   // fills against order 1
+    assert(rejected == 2 && log.LastLsn() == 5);
+    assert(live.Size() == 2);
+    log.Close();
+
+    Orderbook recovered(ladder_config(1, 100));
+    recovered.EnableEvents(true);
+    Trades replayed;
+    uint64_t recoveredCount = RecoverCommandLog(recovered, path, replayed);
+    std::remove(path);
+    assert(recoveredCount == 5);
+    assert(recovered.Size() == live.Size());
+    assert(recovered.GetEventSeq() == live.GetEventSeq());
+    assert(recovered.GetMatchedOrders() == live.GetMatchedOrders());
+    assert(recovered.GetBestBidPrice() == live.GetBestBidPrice());
+    assert(recovered.GetBestBidQuantity() == live.GetBestBidQuantity());
+    assert(recovered.GetBestAskPrice() == live.GetBestAskPrice());
+}
+
+void test_command_log_commit_per_append() {
+    const char* path = "ob_correctness_commands_1.log";
+
+    // Every Append fills the group and commits it before returning the LSN
+    CommandLog log;
+    CommandLogConfig config;
+    config.groupCommitCount_ = 1;
+    log.Open(path, config);
+    Command c;
+    c.type_ = CommandType::Add;
+    c.side_ = Side::Buy;
+    c.price_ = 100;
+    c.quantity_ = 1;
+    for (uint64_t i = 1; i <= 4; ++i) {
+        c.orderId_ = i;
+        uint64_t lsn = log.Append(c, 0);
+        assert(lsn == i);
+        assert(log.DurableLsn() == i && log.CommitCount() == i);
+    }
+    log.Close();
+    std::remove(path);
+}
+
+void test_process_batch_matches_single_commands() {
+    auto cmd = [](CommandType type, OrderType orderType, OrderId id, Side side, Price price, Quantity qty) {
+        Command c;
+        c.type_ = type;
+        c.orderType_ = orderType;
+        c.orderId_ = id;
+        c.side_ = side;
+        c.price_ = price;
+        c.quantity_ = qty;
+        return c;
+    };
+    const std::vector<Command> commands = {
+        cmd(CommandType::Add, OrderType::GoodTillCancel, 1, Side::Sell, 101, 5),
+        cmd(CommandType::Add, OrderType::GoodTillCancel, 2, Side::Sell, 102, 5),
+        cmd(CommandType::Add, OrderType::GoodTillCancel, 3, Side::Buy, 99, 4),
+        cmd(CommandType::Add, OrderType::ImmediateOrCancel, 4, Side::Buy, 100, 3),   // no cross: rejected
+        cmd(CommandType::Add, OrderType::ImmediateOrCancel, 5, Side::Buy, 101, 8),   // fills 5, rest cancelled
+        cmd(CommandType::Add, OrderType::FillOrKill, 6, Side::Sell, 99, 9),          // not enough depth
+        cmd(CommandType::Add, OrderType::GoodTillCancel, 7, Side::Buy, 98, 2),
+        cmd(CommandType::Modify, OrderType::GoodTillCancel, 3, Side::Buy, 102, 6),   // crosses order 2
+        cmd(CommandType::Cancel, OrderType::GoodTillCancel, 7, Side::Buy, 0, 0),
+        cmd(CommandType::Add, OrderType::Market, 8, Side::Sell, 0, 3),
+        cmd(CommandType::Add, OrderType::GoodTillCancel, 1, Side::Buy, 97, 1),       // id 1 is free again
+    };
+
+    std::vector<std::string> singleEvents, batchEvents;
+    Orderbook single, batched;
+    single.SetObserver([&](const Event& e) { singleEvents.push_back(e.to_csv()); });
+    batched.SetObserver([&](const Event& e) { batchEvents.push_back(e.to_csv()); });
+    single.EnableEvents(true);
+    batched.EnableEvents(true);
+
+    Trades singleTrades, batchTrades;
+    for (const Command& c : commands) {
+        switch (c.type_) {
+        case CommandType::Add:    single.AddOrder(Order(c.orderType_, c.orderId_, c.side_, c.price_, c.quantity_), singleTrades); break;
+        case CommandType::Cancel: single.CancelOrder(c.orderId_); break;
+        case CommandType::Modify: single.MatchOrder(OrderModify(c.orderId_, c.side_, c.price_, c.quantity_), singleTrades); break;
+        }
+    }
+    batched.ProcessBatch(std::span<const Command>(commands).first(5), batchTrades);
+    batched.ProcessBatch(std::span<const Command>(commands).subspan(5), batchTrades);
+
+    assert(singleTrades.size() == 3 && batchTrades.size() == singleTrades.size());
+    for (size_t i = 0; i < singleTrades.size(); ++i) {
+        assert(singleTrades[i].GetBidTrade().orderId_ == batchTrades[i].GetBidTrade().orderId_);
+        assert(singleTrades[i].GetAskTrade().orderId_ == batchTrades[i].GetAskTrade().orderId_);
+        assert(singleTrades[i].GetAskTrade().price_ == batchTrades[i].GetAskTrade().price_);
+        assert(singleTrades[i].GetAskTrade().quantity_ == batchTrades[i].GetAskTrade().quantity_);
+    }
+    assert(singleEvents == batchEvents);
+    assert(batched.Size() == single.Size() && batched.GetMatchedOrders() == single.GetMatchedOrders());
+    assert(batched.GetBestBidPrice() == single.GetBestBidPrice() && batched.GetBestAskPrice() == single.GetBestAskPrice());
+}
+
+void test_modify_reduce_in_place_keeps_priority() {
+    std::vector<Event::Type> events;
+    Orderbook ob;
+    ob.SetObserver([&](const Event& e) { events.push_back(e.type); });
+    ob.EnableEvents(true);
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 1, Side::Sell, 100, 10));
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 2, Side::Sell, 100, 5));
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 3, Side::Sell, 100, 5));
+
+    // Same price, smaller size: a single MODIFY event, no cancel / re-add
+    events.clear();
+    auto trades = ob.MatchOrder(OrderModify(1, Side::Sell, 100, 4));
+    assert(trades.empty());
+    assert(events.size() == 1 && events[0] == Event::EVT_MODIFY);
+    assert(ob.Size() == 3 && ob.GetBestAskQuantity() == 14);
+
+    // Larger size: cancel / replace, order 2 goes to the back of the level
+    events.clear();
+    ob.MatchOrder(OrderModify(2, Side::Sell, 100, 6));
+    assert(events.size() == 3 && events[1] == Event::EVT_CANCEL && events[2] == Event::EVT_ADD);
+    assert(ob.GetBestAskQuantity() == 15);
+
+    // Order 1 kept its place at the front, order 2 lost it
+    trades = ob.AddOrder(Order(OrderType::Market, 9, Side::Buy, 0, 15));
+    assert(trades.size() == 3);
+    assert(trades[0].GetAskTrade().orderId_ == 1 && trades[0].GetAskTrade().quantity_ == 4);
+    assert(trades[1].GetAskTrade().orderId_ == 3 && trades[1].GetAskTrade().quantity_ == 5);
+    assert(trades[2].GetAskTrade().orderId_ == 2 && trades[2].GetAskTrade().quantity_ == 6);
+    assert(ob.Size() == 0);
+
+    // A partially filled order shrinks to the new remaining quantity; the
+    // in-place test uses what is left, not the original size
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 4, Side::Buy, 99, 10));
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 5, Side::Sell, 99, 3));
+    assert(ob.FindOrder(5) == nullptr && ob.FindOrder(4)->GetRemainingQuantity() == 7);
+    assert(!ob.ModifiesInPlace(OrderModify(4, Side::Buy, 99, 8)));
+    assert(!ob.ModifiesInPlace(OrderModify(5, Side::Sell, 99, 1)));
+    assert(ob.ModifiesInPlace(OrderModify(4, Side::Buy, 99, 2)));
+    ob.MatchOrder(OrderModify(4, Side::Buy, 99, 2));
+    assert(ob.GetBestBidPrice() == 99 && ob.GetBestBidQuantity() == 2);
+    auto levels = ob.GetOrderInfos();
+    assert(levels.GetBids().size() == 1 && levels.GetBids()[0].quantity_ == 2);
+
+    // A price change is still a cancel / replace and can match
+    ob.AddOrder(Order(OrderType::GoodTillCancel, 6, Side::Sell, 101, 2));
+    trades = ob.MatchOrder(OrderModify(6, Side::Sell, 99, 1));
+    assert(trades.size() == 1 && trades[0].GetBidTrade().orderId_ == 4);
+    assert(ob.GetBestBidQuantity() == 1);
+}
+
+void test_latency_histogram_percentiles() {
+    LatencyHistogram h;
+    assert(h.Count() == 0 && h.Percentile(0.5) == 0 && h.Max() == 0);
+
+    // Small values are exact
+    for (uint64_t v = 1; v <= 100; ++v) h.Record(v);
+    assert(h.Count() == 100 && h.Min() == 1 && h.Max() == 100);
+    assert(h.Percentile(0.50) == 50 && h.Percentile(0.99) == 99 && h.Percentile(1.0) == 100);
+
+    // Large values land within the bucket precision, max stays exact
+    LatencyHistogram big;
+    const uint64_t value = 123'456'789;
+    big.Record(value);
+    uint64_t reported = big.Percentile(0.5);
+    assert(reported == value);                  // capped at the exact max
+    big.Record(value - 1000);
+    reported = big.Percentile(0.5);
+    assert(reported >= value - 1000 && reported - (value - 1000) <= (value - 1000) / 128);
+    assert(big.Max() == value);
+
+    // Bucket bounds are contiguous
+    for (size_t i = 1; i < LatencyHistogram::BucketCount; ++i)
+        assert(LatencyHistogram::BucketLow(i) == LatencyHistogram::BucketHigh(i - 1) + 1);
+
+    // Merging equals recording into one histogram
+    h.Merge(big);
+    assert(h.Count() == 102 && h.Max() == value && h.Min() == 1);
+    assert(h.Percentile(0.5) == 51);
+    uint64_t buckets = 0;
+    h.ForEachBucket([&](uint64_t, uint64_t, uint64_t count) { buckets += count; });
+    assert(buckets == h.Count());
+}
+
+void test_tsc_clock_calibration() {
+    // Forced fallback: ticks are steady_clock ns
+    const ClockCalibration &steady = TscClock::Calibrate(std::chrono::milliseconds{ 5 }, false);
+    assert(steady.source_ == ClockSource::Steady && TscClock::Source() == ClockSource::Steady);
+    assert(steady.ticksPerNs_ == 1.0 && TscClock::ToNs(12345) == 12345);
+
+    // Whichever source is chosen, a timed sleep converts to about its length
+    const ClockCalibration &c = TscClock::Calibrate(std::chrono::milliseconds{ 20 });
+    assert(c.ticksPerNs_ > 0);
+    assert(c.source_ == ClockSource::Steady || c.invariantTsc_);
+    uint64_t t0 = TscClock::Start();
+    std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+    uint64_t ns = TscClock::ToNs(TscClock::Stop() - t0);
+    assert(ns >= 9'000'000 && ns < 1'000'000'000);
+    assert(TscClock::Now() >= t0);
+}
+
 int main() {
     test_market_buy_sweeps_asks();
     test_market_sell_sweeps_bids();
@@ -173,6 +1141,29 @@ int main() {
     test_fok_buy_fail();
     test_fok_buy_success();
     test_gtc_resting_after_market();
+    test_cancel_middle_keeps_fifo();
+    test_order_index_grow_and_extract();
+    test_level_aggregates();
+    test_top_of_book_incremental();
+    test_trade_sink_appends();
+    test_ladder_sweep_across_words();
+    test_ladder_cancel_moves_best();
+    test_ladder_rejects_out_of_band();
+    test_ladder_rejects_out_of_band_modify();
+    test_matching_thread_round_trip();
+    test_matching_thread_rejects_book_errors();
+    test_matching_thread_publishes_events();
+    test_matching_engine_routes_symbols();
+    test_event_journal_matches_observer();
+    test_snapshot_restore_preserves_state();
+    test_trace_conversion_checks_ranges();
+    test_command_log_group_commit_and_recover();
+    test_command_log_recovers_past_rejected_command();
+    test_command_log_commit_per_append();
+    test_process_batch_matches_single_commands();
+    test_modify_reduce_in_place_keeps_priority();
+    test_latency_histogram_percentiles();
+    test_tsc_clock_calibration();
 
     std::cout << "ALL ORDERBOOK CORRECTNESS TESTS PASSED\n";
     return 0;
@@ -0,0 +1,36 @@
+// trace_convert_main.cpp
+// ----------------------
+// Converts benchmark op traces between the CSV format (trace_ops_<scenario>.csv)
+// and the fixed-width binary format (see BinaryTrace.h).
+//
+//   trace_convert.exe csv2bin <in.csv> <out.bin>
+//   trace_convert.exe bin2csv <in.bin> <out.csv>
+
+#include "BinaryTrace.h"
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    if (argc != 4) {
+        std::cerr << "usage: " << argv[0] << " csv2bin|bin2csv <input> <output>\n";
+        return 2;
+    }
+    const std::string mode = argv[1];
+    try {
+        std::uint64_t records = 0;
+        if (mode == "csv2bin")
+            records = ConvertTraceCsvToBinary(argv[2], argv[3]);
+        else if (mode == "bin2csv")
+            records = ConvertTraceBinaryToCsv(argv[2], argv[3]);
+        else {
+            std::cerr << "unknown mode '" << mode << "' (expected csv2bin or bin2csv)\n";
+            return 2;
+        }
+        std::cout << "Converted " << records << " records: " << argv[2] << " -> " << argv[3] << "\n";
+    } catch (const std::exception& ex) {
+        std::cerr << "trace_convert: " << ex.what() << "\n";
+        return 1;
+    }
+    return 0;
+}